@@ -0,0 +1,366 @@
+/* See LICENSE file for license and copyright information */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include <girara/datastructures.h>
+
+#include "plugin.h"
+#include "shim.h"
+
+/*
+ * Calls the plugin callbacks directly on a document of the corpus and reports
+ * latency percentiles and the peak resident set size.
+ */
+
+/* Term searched for by the search benchmark (see corpus.c) */
+#define SEARCH_TERM "needle"
+/* Number of times a document is opened by the open benchmark */
+#define OPEN_ITERATIONS 20
+/* Number of times the outline is read by the index benchmark */
+#define INDEX_ITERATIONS 20
+
+typedef void (*bench_function_t)(zathura_document_t* document, GArray* samples);
+
+static gint64
+bench_now(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (gint64) now.tv_sec * G_GINT64_CONSTANT(1000000000) + now.tv_nsec;
+}
+
+static void
+bench_add_sample(GArray* samples, gint64 start)
+{
+  const double milliseconds = (bench_now() - start) / 1e6;
+  g_array_append_val(samples, milliseconds);
+}
+
+static bool
+bench_open(zathura_document_t* document)
+{
+  if (pdf_document_open(document) != ZATHURA_ERROR_OK) {
+    fprintf(stderr, "Could not open %s\n", zathura_document_get_path(document));
+    return false;
+  }
+
+  return true;
+}
+
+static void
+bench_close(zathura_document_t* document)
+{
+  pdf_document_free(document, zathura_document_get_data(document));
+}
+
+/* Opens the document and initializes all pages */
+static bool
+bench_open_pages(zathura_document_t* document)
+{
+  if (bench_open(document) == false) {
+    return false;
+  }
+
+  const unsigned int n_pages = zathura_document_get_number_of_pages(document);
+  for (unsigned int i = 0; i < n_pages; i++) {
+    if (pdf_page_init(bench_document_create_page(document, i)) != ZATHURA_ERROR_OK) {
+      fprintf(stderr, "Could not initialize page %u\n", i + 1);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void
+bench_close_pages(zathura_document_t* document)
+{
+  const unsigned int n_pages = zathura_document_get_number_of_pages(document);
+  for (unsigned int i = 0; i < n_pages; i++) {
+    zathura_page_t* page = zathura_document_get_page(document, i);
+    pdf_page_clear(page, zathura_page_get_data(page));
+  }
+
+  bench_close(document);
+}
+
+static void
+bench_document_open(zathura_document_t* document, GArray* samples)
+{
+  for (unsigned int i = 0; i < OPEN_ITERATIONS; i++) {
+    const gint64 start = bench_now();
+    if (bench_open(document) == false) {
+      return;
+    }
+    bench_add_sample(samples, start);
+
+    bench_close(document);
+  }
+}
+
+static void
+bench_page_init(zathura_document_t* document, GArray* samples)
+{
+  if (bench_open(document) == false) {
+    return;
+  }
+
+  const unsigned int n_pages = zathura_document_get_number_of_pages(document);
+  for (unsigned int i = 0; i < n_pages; i++) {
+    zathura_page_t* page = bench_document_create_page(document, i);
+
+    const gint64 start = bench_now();
+    pdf_page_init(page);
+    bench_add_sample(samples, start);
+  }
+
+  bench_close_pages(document);
+}
+
+static void
+bench_page_render(zathura_document_t* document, GArray* samples)
+{
+  if (bench_open_pages(document) == false) {
+    return;
+  }
+
+  const unsigned int n_pages = zathura_document_get_number_of_pages(document);
+  for (unsigned int i = 0; i < n_pages; i++) {
+    zathura_page_t* page = zathura_document_get_page(document, i);
+
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+        zathura_page_get_width(page), zathura_page_get_height(page));
+    cairo_t* cairo = cairo_create(surface);
+    cairo_set_source_rgb(cairo, 1, 1, 1);
+    cairo_paint(cairo);
+
+    const gint64 start = bench_now();
+    pdf_page_render_cairo(page, zathura_page_get_data(page), cairo, false);
+    bench_add_sample(samples, start);
+
+    cairo_destroy(cairo);
+    cairo_surface_destroy(surface);
+  }
+
+  bench_close_pages(document);
+}
+
+/* Searches all pages twice and only samples the given pass: the first (cold)
+ * pass is the first search of every page, the second (warm) one searches the
+ * pages again. */
+static void
+bench_page_search_pass(zathura_document_t* document, GArray* samples, unsigned int sampled)
+{
+  if (bench_open_pages(document) == false) {
+    return;
+  }
+
+  const unsigned int n_pages = zathura_document_get_number_of_pages(document);
+  for (unsigned int pass = 0; pass <= sampled; pass++) {
+    for (unsigned int i = 0; i < n_pages; i++) {
+      zathura_page_t* page  = zathura_document_get_page(document, i);
+      zathura_error_t error = ZATHURA_ERROR_OK;
+
+      const gint64 start  = bench_now();
+      girara_list_t* list = pdf_page_search_text(page, zathura_page_get_data(page),
+          SEARCH_TERM, &error);
+      if (pass == sampled) {
+        bench_add_sample(samples, start);
+      }
+
+      if (list != NULL) {
+        girara_list_free(list);
+      }
+    }
+  }
+
+  bench_close_pages(document);
+}
+
+static void
+bench_page_search(zathura_document_t* document, GArray* samples)
+{
+  bench_page_search_pass(document, samples, 0);
+}
+
+static void
+bench_page_search_warm(zathura_document_t* document, GArray* samples)
+{
+  bench_page_search_pass(document, samples, 1);
+}
+
+static void
+bench_page_links(zathura_document_t* document, GArray* samples)
+{
+  if (bench_open_pages(document) == false) {
+    return;
+  }
+
+  const unsigned int n_pages = zathura_document_get_number_of_pages(document);
+  for (unsigned int i = 0; i < n_pages; i++) {
+    zathura_page_t* page  = zathura_document_get_page(document, i);
+    zathura_error_t error = ZATHURA_ERROR_OK;
+
+    const gint64 start  = bench_now();
+    girara_list_t* list = pdf_page_links_get(page, zathura_page_get_data(page), &error);
+    bench_add_sample(samples, start);
+
+    if (list != NULL) {
+      girara_list_free(list);
+    }
+  }
+
+  bench_close_pages(document);
+}
+
+static void
+bench_page_images(zathura_document_t* document, GArray* samples)
+{
+  if (bench_open_pages(document) == false) {
+    return;
+  }
+
+  const unsigned int n_pages = zathura_document_get_number_of_pages(document);
+  for (unsigned int i = 0; i < n_pages; i++) {
+    zathura_page_t* page  = zathura_document_get_page(document, i);
+    void* data            = zathura_page_get_data(page);
+    zathura_error_t error = ZATHURA_ERROR_OK;
+
+    const gint64 start  = bench_now();
+    girara_list_t* list = pdf_page_images_get(page, data, &error);
+    if (list != NULL) {
+      for (size_t j = 0; j < girara_list_size(list); j++) {
+        zathura_image_t* image   = girara_list_nth(list, j);
+        cairo_surface_t* surface = pdf_page_image_get_cairo(page, data, image, &error);
+        if (surface != NULL) {
+          cairo_surface_destroy(surface);
+        }
+      }
+    }
+    bench_add_sample(samples, start);
+
+    if (list != NULL) {
+      girara_list_free(list);
+    }
+  }
+
+  bench_close_pages(document);
+}
+
+static void
+bench_document_index(zathura_document_t* document, GArray* samples)
+{
+  if (bench_open(document) == false) {
+    return;
+  }
+
+  for (unsigned int i = 0; i < INDEX_ITERATIONS; i++) {
+    zathura_error_t error = ZATHURA_ERROR_OK;
+
+    const gint64 start       = bench_now();
+    girara_tree_node_t* root = pdf_document_index_generate(document,
+        zathura_document_get_data(document), &error);
+    bench_add_sample(samples, start);
+
+    if (root != NULL) {
+      girara_node_free(root);
+    }
+  }
+
+  bench_close(document);
+}
+
+static const struct {
+  const char* name; /**< Name of the benchmark */
+  bench_function_t function; /**< Benchmark function */
+} benchmarks[] = {
+  { "open", bench_document_open },
+  { "page-init", bench_page_init },
+  { "render", bench_page_render },
+  { "search", bench_page_search },
+  { "search-warm", bench_page_search_warm },
+  { "links", bench_page_links },
+  { "images", bench_page_images },
+  { "index", bench_document_index }
+};
+
+static int
+bench_compare(const void* a, const void* b)
+{
+  const double x = *(const double*) a;
+  const double y = *(const double*) b;
+
+  return (x > y) - (x < y);
+}
+
+static double
+bench_percentile(GArray* samples, double percentile)
+{
+  const guint index = MIN((guint) (percentile / 100 * samples->len), samples->len - 1);
+  return g_array_index(samples, double, index);
+}
+
+int
+main(int argc, char* argv[])
+{
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s BENCHMARK FILE\n", argv[0]);
+    return 1;
+  }
+
+  bench_function_t function = NULL;
+  for (size_t i = 0; i < G_N_ELEMENTS(benchmarks); i++) {
+    if (strcmp(argv[1], benchmarks[i].name) == 0) {
+      function = benchmarks[i].function;
+    }
+  }
+
+  if (function == NULL) {
+    fprintf(stderr, "Unknown benchmark: %s\n", argv[1]);
+    return 1;
+  }
+
+  /* the plugin is configured through the environment; the benchmarks always
+   * measure the defaults, whatever the caller has set */
+  gchar** variables = g_listenv();
+  for (gchar** variable = variables; *variable != NULL; variable++) {
+    if (g_str_has_prefix(*variable, "ZATHURA_PDF_POPPLER_") == TRUE) {
+      g_unsetenv(*variable);
+    }
+  }
+  g_strfreev(variables);
+
+  zathura_document_t* document = bench_document_new(argv[2], NULL);
+  GArray* samples              = g_array_new(FALSE, FALSE, sizeof(double));
+
+  const gint64 start = bench_now();
+  function(document, samples);
+  const double total = (bench_now() - start) / 1e6;
+
+  bench_document_free(document);
+
+  if (samples->len == 0) {
+    fprintf(stderr, "%s: no samples\n", argv[1]);
+    g_array_free(samples, TRUE);
+    return 1;
+  }
+
+  g_array_sort(samples, bench_compare);
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  printf("%s %s: %u samples, total %.1f ms\n", argv[1], argv[2], samples->len, total);
+  printf("  p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+      bench_percentile(samples, 50), bench_percentile(samples, 90),
+      bench_percentile(samples, 99), g_array_index(samples, double, samples->len - 1));
+  printf("  peak RSS %ld KiB\n", usage.ru_maxrss);
+
+  g_array_free(samples, TRUE);
+
+  return 0;
+}
@@ -0,0 +1,288 @@
+/* See LICENSE file for license and copyright information */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+#include <cairo.h>
+#include <cairo-pdf.h>
+
+/*
+ * Generates the documents of the benchmark corpus. The contents are derived
+ * from a fixed seed, so every build produces the same documents.
+ */
+
+#define PAGE_WIDTH 595.0
+#define PAGE_HEIGHT 842.0
+
+/* Word that is spread over the text document for the search benchmark */
+#define SEARCH_TERM "needle"
+
+static const char* words[] = {
+  "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+  "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+  "et", "dolore", "magna", "aliqua", "enim", "ad", "minim", "veniam",
+  "quis", "nostrud", "exercitation", "ullamco", "laboris", "nisi",
+  "aliquip", "ex", "ea", "commodo", "consequat", "duis", "aute", "irure",
+  "in", "reprehenderit", "voluptate", "velit", "esse", "cillum", "fugiat",
+  "nulla", "pariatur", "excepteur", "sint", "occaecat", "cupidatat"
+};
+
+typedef void (*corpus_function_t)(cairo_surface_t* surface, cairo_t* cairo);
+
+static guint32 seed = 1;
+
+static guint32
+corpus_random(void)
+{
+  seed = seed * 1664525 + 1013904223;
+  return seed >> 8;
+}
+
+static double
+corpus_random_double(double max)
+{
+  return max * (corpus_random() & 0xFFFF) / 65536.0;
+}
+
+/* Many pages with little content */
+static void
+corpus_pages(cairo_surface_t* surface, cairo_t* cairo)
+{
+  (void) surface;
+
+  cairo_select_font_face(cairo, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cairo, 24);
+
+  for (unsigned int page = 0; page < 5000; page++) {
+    char label[32];
+    snprintf(label, sizeof(label), "Page %u", page + 1);
+    cairo_move_to(cairo, 72, 96);
+    cairo_show_text(cairo, label);
+    cairo_show_page(cairo);
+  }
+}
+
+/* Pages densely filled with small text */
+static void
+corpus_text(cairo_surface_t* surface, cairo_t* cairo)
+{
+  (void) surface;
+
+  cairo_select_font_face(cairo, "Serif", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cairo, 7);
+
+  GString* line = g_string_new(NULL);
+  for (unsigned int page = 0; page < 300; page++) {
+    for (unsigned int row = 0; row < 95; row++) {
+      g_string_truncate(line, 0);
+      while (line->len < 130) {
+        const char* word = (corpus_random() % 200 == 0) ? SEARCH_TERM :
+          words[corpus_random() % G_N_ELEMENTS(words)];
+        g_string_append(line, word);
+        g_string_append_c(line, ' ');
+      }
+
+      cairo_move_to(cairo, 36, 40 + row * 8);
+      cairo_show_text(cairo, line->str);
+    }
+    cairo_show_page(cairo);
+  }
+  g_string_free(line, TRUE);
+}
+
+/* Pages with many curved paths */
+static void
+corpus_vector(cairo_surface_t* surface, cairo_t* cairo)
+{
+  (void) surface;
+
+  cairo_set_line_width(cairo, 0.5);
+
+  for (unsigned int page = 0; page < 40; page++) {
+    for (unsigned int path = 0; path < 4000; path++) {
+      cairo_move_to(cairo, corpus_random_double(PAGE_WIDTH), corpus_random_double(PAGE_HEIGHT));
+      for (unsigned int segment = 0; segment < 4; segment++) {
+        cairo_curve_to(cairo,
+            corpus_random_double(PAGE_WIDTH), corpus_random_double(PAGE_HEIGHT),
+            corpus_random_double(PAGE_WIDTH), corpus_random_double(PAGE_HEIGHT),
+            corpus_random_double(PAGE_WIDTH), corpus_random_double(PAGE_HEIGHT));
+      }
+
+      cairo_set_source_rgba(cairo, corpus_random_double(1), corpus_random_double(1),
+          corpus_random_double(1), 0.5);
+      if (path % 8 == 0) {
+        cairo_close_path(cairo);
+        cairo_fill(cairo);
+      } else {
+        cairo_stroke(cairo);
+      }
+    }
+    cairo_show_page(cairo);
+  }
+}
+
+/* Pages with one large image each */
+static void
+corpus_images(cairo_surface_t* surface, cairo_t* cairo)
+{
+  (void) surface;
+
+  const int size = 2048;
+
+  for (unsigned int page = 0; page < 8; page++) {
+    cairo_surface_t* image = cairo_image_surface_create(CAIRO_FORMAT_RGB24, size, size);
+    unsigned char* data    = cairo_image_surface_get_data(image);
+    const int stride       = cairo_image_surface_get_stride(image);
+
+    for (int y = 0; y < size; y++) {
+      guint32* row = (guint32*) (data + (size_t) y * stride);
+      for (int x = 0; x < size; x++) {
+        const guint32 r = (x + page * 32) & 0xFF;
+        const guint32 g = (y / 2 + (corpus_random() & 0x7)) & 0xFF;
+        const guint32 b = ((x ^ y) >> 3) & 0xFF;
+        row[x] = (r << 16) | (g << 8) | b;
+      }
+    }
+    cairo_surface_mark_dirty(image);
+
+    cairo_save(cairo);
+    cairo_translate(cairo, 36, 36);
+    cairo_scale(cairo, (PAGE_WIDTH - 72) / size, (PAGE_WIDTH - 72) / size);
+    cairo_set_source_surface(cairo, image, 0, 0);
+    cairo_paint(cairo);
+    cairo_restore(cairo);
+
+    cairo_surface_destroy(image);
+    cairo_show_page(cairo);
+  }
+}
+
+/* Pages with many links to other pages and to URIs */
+static void
+corpus_links(cairo_surface_t* surface, cairo_t* cairo)
+{
+  (void) surface;
+
+  const unsigned int n_pages = 200;
+
+  cairo_select_font_face(cairo, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cairo, 8);
+
+  for (unsigned int page = 0; page < n_pages; page++) {
+    for (unsigned int link = 0; link < 40; link++) {
+      char attributes[128];
+      char label[32];
+      if (link % 2 == 0) {
+        const unsigned int target = corpus_random() % n_pages;
+        snprintf(attributes, sizeof(attributes), "page=%u pos=[72 %u]", target + 1,
+            (unsigned int) corpus_random_double(PAGE_HEIGHT));
+        snprintf(label, sizeof(label), "Go to page %u", target + 1);
+      } else {
+        snprintf(attributes, sizeof(attributes), "uri='https://example.org/%u/%u'",
+            page, link);
+        snprintf(label, sizeof(label), "Link %u.%u", page, link);
+      }
+
+      cairo_tag_begin(cairo, CAIRO_TAG_LINK, attributes);
+      cairo_move_to(cairo, 36 + (link % 4) * 130, 40 + (link / 4) * 72);
+      cairo_show_text(cairo, label);
+      cairo_tag_end(cairo, CAIRO_TAG_LINK);
+    }
+    cairo_show_page(cairo);
+  }
+}
+
+static void
+corpus_add_outline(cairo_surface_t* surface, int parent, unsigned int depth,
+    unsigned int n_pages, const char* prefix)
+{
+  for (unsigned int i = 0; i < 3; i++) {
+    char title[128];
+    char attributes[32];
+    snprintf(title, sizeof(title), "%s%u.", prefix, i + 1);
+    snprintf(attributes, sizeof(attributes), "page=%u", corpus_random() % n_pages + 1);
+
+    const int id = cairo_pdf_surface_add_outline(surface, parent, title, attributes,
+        depth == 0 ? CAIRO_PDF_OUTLINE_FLAG_OPEN : 0);
+    if (depth < 6) {
+      corpus_add_outline(surface, id, depth + 1, n_pages, title);
+    }
+  }
+}
+
+/* Pages with a deep outline */
+static void
+corpus_outline(cairo_surface_t* surface, cairo_t* cairo)
+{
+  const unsigned int n_pages = 1000;
+
+  cairo_select_font_face(cairo, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cairo, 24);
+
+  for (unsigned int page = 0; page < n_pages; page++) {
+    char label[32];
+    snprintf(label, sizeof(label), "Section page %u", page + 1);
+    cairo_move_to(cairo, 72, 96);
+    cairo_show_text(cairo, label);
+    cairo_show_page(cairo);
+  }
+
+  corpus_add_outline(surface, CAIRO_PDF_OUTLINE_ROOT, 0, n_pages, "");
+}
+
+static const struct {
+  const char* name; /**< File name of the document */
+  corpus_function_t function; /**< Generator of the document */
+} corpus[] = {
+  { "pages.pdf", corpus_pages },
+  { "text.pdf", corpus_text },
+  { "vector.pdf", corpus_vector },
+  { "images.pdf", corpus_images },
+  { "links.pdf", corpus_links },
+  { "outline.pdf", corpus_outline }
+};
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s FILE...\n", argv[0]);
+    return 1;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    char* name                 = g_path_get_basename(argv[i]);
+    corpus_function_t function = NULL;
+    for (size_t j = 0; j < G_N_ELEMENTS(corpus); j++) {
+      if (strcmp(name, corpus[j].name) == 0) {
+        function = corpus[j].function;
+      }
+    }
+    g_free(name);
+
+    if (function == NULL) {
+      fprintf(stderr, "Unknown corpus document: %s\n", argv[i]);
+      return 1;
+    }
+
+    /* every document starts from the same seed */
+    seed = 1;
+
+    cairo_surface_t* surface = cairo_pdf_surface_create(argv[i], PAGE_WIDTH, PAGE_HEIGHT);
+    cairo_t* cairo           = cairo_create(surface);
+    function(surface, cairo);
+    cairo_destroy(cairo);
+    cairo_surface_finish(surface);
+
+    const cairo_status_t status = cairo_surface_status(surface);
+    cairo_surface_destroy(surface);
+    if (status != CAIRO_STATUS_SUCCESS) {
+      fprintf(stderr, "Could not write %s: %s\n", argv[i], cairo_status_to_string(status));
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,278 @@
+/* See LICENSE file for license and copyright information */
+
+#include <girara/datastructures.h>
+
+#include "shim.h"
+
+struct zathura_document_s {
+  char* path; /**< Path of the file */
+  char* password; /**< Password of the file or NULL */
+  void* data; /**< Plugin data */
+  unsigned int number_of_pages; /**< Number of pages */
+  zathura_page_t** pages; /**< Pages (NULL until the pages are created) */
+};
+
+struct zathura_page_s {
+  zathura_document_t* document; /**< The document the page belongs to */
+  unsigned int index; /**< Page index */
+  double width; /**< Page width */
+  double height; /**< Page height */
+  void* data; /**< Plugin data */
+};
+
+struct zathura_link_s {
+  zathura_link_type_t type; /**< Link type */
+  zathura_rectangle_t position; /**< Position of the link */
+  zathura_link_target_t target; /**< Link target */
+};
+
+zathura_document_t*
+bench_document_new(const char* path, const char* password)
+{
+  zathura_document_t* document = g_malloc0(sizeof(zathura_document_t));
+  document->path               = g_strdup(path);
+  document->password           = g_strdup(password);
+
+  return document;
+}
+
+void
+bench_document_free(zathura_document_t* document)
+{
+  if (document == NULL) {
+    return;
+  }
+
+  if (document->pages != NULL) {
+    for (unsigned int i = 0; i < document->number_of_pages; i++) {
+      g_free(document->pages[i]);
+    }
+    g_free(document->pages);
+  }
+
+  g_free(document->path);
+  g_free(document->password);
+  g_free(document);
+}
+
+zathura_page_t*
+bench_document_create_page(zathura_document_t* document, unsigned int index)
+{
+  if (document->pages == NULL) {
+    document->pages = g_malloc0(sizeof(zathura_page_t*) * MAX(document->number_of_pages, 1));
+  }
+
+  if (document->pages[index] == NULL) {
+    zathura_page_t* page = g_malloc0(sizeof(zathura_page_t));
+    page->document       = document;
+    page->index          = index;
+    document->pages[index] = page;
+  }
+
+  return document->pages[index];
+}
+
+const char*
+zathura_document_get_path(zathura_document_t* document)
+{
+  return document->path;
+}
+
+const char*
+zathura_document_get_password(zathura_document_t* document)
+{
+  return document->password;
+}
+
+void*
+zathura_document_get_data(zathura_document_t* document)
+{
+  return document->data;
+}
+
+void
+zathura_document_set_data(zathura_document_t* document, void* data)
+{
+  document->data = data;
+}
+
+unsigned int
+zathura_document_get_number_of_pages(zathura_document_t* document)
+{
+  return document->number_of_pages;
+}
+
+void
+zathura_document_set_number_of_pages(zathura_document_t* document, unsigned int number_of_pages)
+{
+  document->number_of_pages = number_of_pages;
+}
+
+zathura_page_t*
+zathura_document_get_page(zathura_document_t* document, unsigned int index)
+{
+  if (document->pages == NULL || index >= document->number_of_pages) {
+    return NULL;
+  }
+
+  return document->pages[index];
+}
+
+zathura_document_t*
+zathura_page_get_document(zathura_page_t* page)
+{
+  return page->document;
+}
+
+unsigned int
+zathura_page_get_index(zathura_page_t* page)
+{
+  return page->index;
+}
+
+double
+zathura_page_get_width(zathura_page_t* page)
+{
+  return page->width;
+}
+
+void
+zathura_page_set_width(zathura_page_t* page, double width)
+{
+  page->width = width;
+}
+
+double
+zathura_page_get_height(zathura_page_t* page)
+{
+  return page->height;
+}
+
+void
+zathura_page_set_height(zathura_page_t* page, double height)
+{
+  page->height = height;
+}
+
+void*
+zathura_page_get_data(zathura_page_t* page)
+{
+  return page->data;
+}
+
+void
+zathura_page_set_data(zathura_page_t* page, void* data)
+{
+  page->data = data;
+}
+
+zathura_link_t*
+zathura_link_new(zathura_link_type_t type, zathura_rectangle_t position,
+    zathura_link_target_t target)
+{
+  zathura_link_t* link = g_malloc0(sizeof(zathura_link_t));
+  link->type           = type;
+  link->position       = position;
+  link->target         = target;
+  link->target.value   = g_strdup(target.value);
+
+  return link;
+}
+
+void
+zathura_link_free(zathura_link_t* link)
+{
+  if (link == NULL) {
+    return;
+  }
+
+  g_free(link->target.value);
+  g_free(link);
+}
+
+zathura_link_type_t
+zathura_link_get_type(zathura_link_t* link)
+{
+  return link != NULL ? link->type : ZATHURA_LINK_INVALID;
+}
+
+zathura_rectangle_t
+zathura_link_get_position(zathura_link_t* link)
+{
+  if (link == NULL) {
+    const zathura_rectangle_t position = { 0, 0, 0, 0 };
+    return position;
+  }
+
+  return link->position;
+}
+
+zathura_link_target_t
+zathura_link_get_target(zathura_link_t* link)
+{
+  if (link == NULL) {
+    const zathura_link_target_t target = { 0 };
+    return target;
+  }
+
+  return link->target;
+}
+
+zathura_index_element_t*
+zathura_index_element_new(const char* title)
+{
+  if (title == NULL) {
+    return NULL;
+  }
+
+  zathura_index_element_t* element = g_malloc0(sizeof(zathura_index_element_t));
+  element->title                   = g_strdup(title);
+
+  return element;
+}
+
+void
+zathura_index_element_free(zathura_index_element_t* element)
+{
+  if (element == NULL) {
+    return;
+  }
+
+  g_free(element->title);
+  zathura_link_free(element->link);
+  g_free(element);
+}
+
+static void
+document_information_entry_free(void* data)
+{
+  zathura_document_information_entry_t* entry = data;
+  if (entry == NULL) {
+    return;
+  }
+
+  g_free(entry->value);
+  g_free(entry);
+}
+
+girara_list_t*
+zathura_document_information_entry_list_new(void)
+{
+  return girara_list_new2(document_information_entry_free);
+}
+
+zathura_document_information_entry_t*
+zathura_document_information_entry_new(zathura_document_information_type_t type,
+    const char* value)
+{
+  if (value == NULL) {
+    return NULL;
+  }
+
+  zathura_document_information_entry_t* entry =
+    g_malloc0(sizeof(zathura_document_information_entry_t));
+  entry->type  = type;
+  entry->value = g_strdup(value);
+
+  return entry;
+}
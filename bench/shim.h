@@ -0,0 +1,40 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef SHIM_H
+#define SHIM_H
+
+#include "plugin.h"
+
+/*
+ * The plugin calls back into zathura for its document, page, link and index
+ * objects. The benchmark provides minimal implementations of these functions,
+ * so the plugin callbacks can be called without zathura.
+ */
+
+/**
+ * Creates a document for a file
+ *
+ * @param path Path of the file
+ * @param password Password of the file or NULL
+ * @return The document
+ */
+zathura_document_t* bench_document_new(const char* path, const char* password);
+
+/**
+ * Frees a document and its pages. The plugin data needs to be freed before.
+ *
+ * @param document The document
+ */
+void bench_document_free(zathura_document_t* document);
+
+/**
+ * Creates a page of an opened document
+ *
+ * @param document The document
+ * @param index Page index
+ * @return The page
+ */
+zathura_page_t* bench_document_create_page(zathura_document_t* document,
+    unsigned int index);
+
+#endif // SHIM_H
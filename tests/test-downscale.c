@@ -0,0 +1,174 @@
+/* See LICENSE file for license and copyright information */
+
+/* The vectorized loops of the row functions are compared with their scalar
+ * versions, so the source is included to reach the static functions. */
+#include "downscale.c"
+
+/* Seed of the random rows, so that failures can be reproduced */
+#define TEST_SEED 0xd05c
+/* Number of random rows that are compared */
+#define TEST_ROWS 4096
+/* Maximal width of a target row, enough for several vectors and every tail */
+#define TEST_MAX_WIDTH 19
+/* Maximal number of source pixels per target pixel */
+#define TEST_MAX_RATIO 5
+
+/* Resamples random rows to random widths with both paths */
+static void
+test_resample(void)
+{
+  GRand* rand        = g_rand_new_with_seed(TEST_SEED);
+  unsigned char* row = g_malloc(4 * TEST_MAX_WIDTH * TEST_MAX_RATIO);
+  float* vector      = g_malloc(sizeof(float) * 4 * TEST_MAX_WIDTH);
+  float* scalar      = g_malloc(sizeof(float) * 4 * TEST_MAX_WIDTH);
+
+  for (unsigned int n = 0; n < TEST_ROWS; n++) {
+    const unsigned int width  = g_rand_int_range(rand, 1, TEST_MAX_WIDTH + 1);
+    const unsigned int source = g_rand_int_range(rand, width, width * TEST_MAX_RATIO + 1);
+    for (unsigned int i = 0; i < 4 * source; i++) {
+      row[i] = g_rand_int_range(rand, 0, 256);
+    }
+
+    downscale_span_t* spans = downscale_get_spans(source, width);
+    downscale_resample_row(row, spans, width, vector);
+    downscale_resample_row_scalar(row, spans, width, scalar);
+    g_free(spans);
+
+    g_assert_cmpmem(vector, sizeof(float) * 4 * width, scalar, sizeof(float) * 4 * width);
+  }
+
+  g_free(scalar);
+  g_free(vector);
+  g_free(row);
+  g_rand_free(rand);
+}
+
+/* Adds random rows of random lengths with both paths */
+static void
+test_accumulate(void)
+{
+  GRand* rand   = g_rand_new_with_seed(TEST_SEED);
+  const guint n = 4 * TEST_MAX_WIDTH;
+  float* row    = g_malloc(sizeof(float) * n);
+  float* vector = g_malloc(sizeof(float) * n);
+  float* scalar = g_malloc(sizeof(float) * n);
+
+  for (unsigned int k = 0; k < TEST_ROWS; k++) {
+    const unsigned int length = g_rand_int_range(rand, 0, n + 1);
+    const float weight        = g_rand_double(rand);
+    for (unsigned int i = 0; i < n; i++) {
+      row[i]    = g_rand_double_range(rand, 0, 255 * TEST_MAX_RATIO);
+      vector[i] = g_rand_double_range(rand, 0, 255 * TEST_MAX_RATIO);
+    }
+    memcpy(scalar, vector, sizeof(float) * n);
+
+    downscale_accumulate_row(vector, row, weight, length);
+    downscale_accumulate_row_scalar(scalar, row, weight, length);
+
+    g_assert_cmpmem(vector, sizeof(float) * n, scalar, sizeof(float) * n);
+  }
+
+  g_free(scalar);
+  g_free(vector);
+  g_free(row);
+  g_rand_free(rand);
+}
+
+/* Stores random sums, including values out of range and exact ties, with
+ * both paths */
+static void
+test_store(void)
+{
+  GRand* rand           = g_rand_new_with_seed(TEST_SEED);
+  float* accumulator    = g_malloc(sizeof(float) * 4 * TEST_MAX_WIDTH);
+  unsigned char* vector = g_malloc(4 * TEST_MAX_WIDTH);
+  unsigned char* scalar = g_malloc(4 * TEST_MAX_WIDTH);
+
+  for (unsigned int k = 0; k < TEST_ROWS; k++) {
+    const unsigned int width = g_rand_int_range(rand, 0, TEST_MAX_WIDTH + 1);
+    const float factor       = g_rand_boolean(rand) == TRUE ? 1 : g_rand_double(rand);
+    for (unsigned int i = 0; i < 4 * width; i++) {
+      if (g_rand_boolean(rand) == TRUE) {
+        accumulator[i] = g_rand_int_range(rand, -2, 258) + 0.5f;
+      } else {
+        accumulator[i] = g_rand_double_range(rand, -10, 300);
+      }
+    }
+
+    downscale_store_row(accumulator, factor, width, vector);
+    downscale_store_row_scalar(accumulator, factor, width, scalar);
+
+    g_assert_cmpmem(vector, 4 * width, scalar, 4 * width);
+  }
+
+  g_free(scalar);
+  g_free(vector);
+  g_free(accumulator);
+  g_rand_free(rand);
+}
+
+/* Ties are rounded to even */
+static void
+test_store_ties(void)
+{
+  const float accumulator[8]      = { 0.5f, 1.5f, 2.5f, 3.5f, 126.5f, 127.5f, 254.5f, 255.5f };
+  const unsigned char expected[8] = { 0, 2, 2, 4, 126, 128, 254, 255 };
+  unsigned char out[8];
+
+  downscale_store_row(accumulator, 1, 2, out);
+  g_assert_cmpmem(out, sizeof(out), expected, sizeof(expected));
+
+  downscale_store_row_scalar(accumulator, 1, 2, out);
+  g_assert_cmpmem(out, sizeof(out), expected, sizeof(expected));
+}
+
+/* A uniform image stays uniform */
+static void
+test_uniform(void)
+{
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 37, 23);
+  g_assert_cmpint(cairo_surface_status(surface), ==, CAIRO_STATUS_SUCCESS);
+
+  const guint32 color = 0x80402010;
+  unsigned char* data = cairo_image_surface_get_data(surface);
+  const int stride    = cairo_image_surface_get_stride(surface);
+  cairo_surface_flush(surface);
+  for (int y = 0; y < 23; y++) {
+    for (int x = 0; x < 37; x++) {
+      memcpy(data + (size_t) y * stride + 4 * x, &color, 4);
+    }
+  }
+  cairo_surface_mark_dirty(surface);
+
+  cairo_surface_t* scaled = pdf_image_downscale(surface, 11, 7);
+  g_assert_nonnull(scaled);
+  g_assert_cmpint(cairo_image_surface_get_width(scaled), ==, 11);
+  g_assert_cmpint(cairo_image_surface_get_height(scaled), ==, 7);
+
+  const unsigned char* scaled_data = cairo_image_surface_get_data(scaled);
+  const int scaled_stride          = cairo_image_surface_get_stride(scaled);
+  for (int y = 0; y < 7; y++) {
+    for (int x = 0; x < 11; x++) {
+      guint32 pixel = 0;
+      memcpy(&pixel, scaled_data + (size_t) y * scaled_stride + 4 * x, 4);
+      g_assert_cmphex(pixel, ==, color);
+    }
+  }
+
+  cairo_surface_destroy(scaled);
+  cairo_surface_destroy(surface);
+}
+
+int
+main(int argc, char* argv[])
+{
+  g_test_init(&argc, &argv, NULL);
+
+  g_test_add_func("/downscale/resample", test_resample);
+  g_test_add_func("/downscale/accumulate", test_accumulate);
+  g_test_add_func("/downscale/store", test_store);
+  g_test_add_func("/downscale/store-ties", test_store_ties);
+  g_test_add_func("/downscale/uniform", test_uniform);
+
+  return g_test_run();
+}
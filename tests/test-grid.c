@@ -0,0 +1,189 @@
+/* See LICENSE file for license and copyright information */
+
+#include <math.h>
+
+#include "grid.h"
+
+/* Seed of the random boxes, so that failures can be reproduced */
+#define TEST_SEED 0x6121d
+/* Number of random grids */
+#define TEST_GRIDS 64
+/* Number of queries per grid */
+#define TEST_QUERIES 256
+
+/* Returns a random coordinate on a page of 600 x 800 points; some boxes lie
+ * partly outside the page, like glyphs of text that is cut off */
+static float
+test_random_coordinate(GRand* rand, double size)
+{
+  return g_rand_double_range(rand, -20, size + 20);
+}
+
+/* Returns random boxes: small ones like glyphs, some large ones spanning
+ * many cells, degenerate ones and ones with swapped corners */
+static float*
+test_random_boxes(GRand* rand, size_t n_boxes)
+{
+  float* boxes = g_malloc(sizeof(float) * 4 * MAX(n_boxes, 1));
+  for (size_t i = 0; i < n_boxes; i++) {
+    float* box = boxes + 4 * i;
+    box[0]     = test_random_coordinate(rand, 600);
+    box[1]     = test_random_coordinate(rand, 800);
+
+    switch (g_rand_int_range(rand, 0, 8)) {
+      case 0:
+        box[2] = test_random_coordinate(rand, 600);
+        box[3] = test_random_coordinate(rand, 800);
+        break;
+      case 1:
+        box[2] = box[0];
+        box[3] = box[1];
+        break;
+      case 2:
+        box[2] = box[0] - g_rand_double_range(rand, 0, 10);
+        box[3] = box[1] - g_rand_double_range(rand, 0, 12);
+        break;
+      default:
+        box[2] = box[0] + g_rand_double_range(rand, 0, 10);
+        box[3] = box[1] + g_rand_double_range(rand, 0, 12);
+        break;
+    }
+  }
+
+  return boxes;
+}
+
+static bool
+test_intersects(const float* box, double left, double top, double right, double bottom)
+{
+  return MAX(box[0], box[2]) >= left && MIN(box[0], box[2]) <= right &&
+    MAX(box[1], box[3]) >= top && MIN(box[1], box[3]) <= bottom;
+}
+
+static double
+test_distance(const float* box, double x, double y)
+{
+  const double dx = MAX(MAX(MIN(box[0], box[2]) - x, x - MAX(box[0], box[2])), 0);
+  const double dy = MAX(MAX(MIN(box[1], box[3]) - y, y - MAX(box[1], box[3])), 0);
+
+  return dx * dx + dy * dy;
+}
+
+/* Compares a query with checking every box */
+static void
+test_check_query(pdf_grid_t* grid, const float* boxes, size_t n_boxes, double x1,
+    double y1, double x2, double y2)
+{
+  GArray* result = g_array_new(FALSE, FALSE, sizeof(guint32));
+  pdf_grid_query(grid, x1, y1, x2, y2, result);
+
+  guint position = 0;
+  for (size_t i = 0; i < n_boxes; i++) {
+    if (test_intersects(boxes + 4 * i, MIN(x1, x2), MIN(y1, y2), MAX(x1, x2), MAX(y1, y2)) == true) {
+      g_assert_cmpuint(position, <, result->len);
+      g_assert_cmpuint(g_array_index(result, guint32, position), ==, i);
+      position++;
+    }
+  }
+  g_assert_cmpuint(position, ==, result->len);
+
+  g_array_free(result, TRUE);
+}
+
+/* Compares the nearest box with checking every box; of several boxes at the
+ * same distance the first one is expected */
+static void
+test_check_nearest(pdf_grid_t* grid, const float* boxes, size_t n_boxes, double x, double y)
+{
+  size_t index = 0;
+  g_assert_true(pdf_grid_nearest(grid, x, y, &index));
+
+  size_t expected = 0;
+  for (size_t i = 1; i < n_boxes; i++) {
+    if (test_distance(boxes + 4 * i, x, y) < test_distance(boxes + 4 * expected, x, y)) {
+      expected = i;
+    }
+  }
+
+  g_assert_cmpfloat(test_distance(boxes + 4 * index, x, y), ==,
+      test_distance(boxes + 4 * expected, x, y));
+  g_assert_cmpuint(index, ==, expected);
+}
+
+static void
+test_random(void)
+{
+  GRand* rand = g_rand_new_with_seed(TEST_SEED);
+
+  for (unsigned int i = 0; i < TEST_GRIDS; i++) {
+    /* from a single box up to pages with thousands of glyphs */
+    const size_t n_boxes = 1 + g_rand_int_range(rand, 0, 8) * g_rand_int_range(rand, 0, 1000);
+    float* boxes         = test_random_boxes(rand, n_boxes);
+    pdf_grid_t* grid     = pdf_grid_new(boxes, n_boxes);
+
+    for (unsigned int j = 0; j < TEST_QUERIES; j++) {
+      /* points and rectangles inside and outside of the boxes' area */
+      const double x = g_rand_double_range(rand, -100, 700);
+      const double y = g_rand_double_range(rand, -100, 900);
+      test_check_nearest(grid, boxes, n_boxes, x, y);
+      test_check_query(grid, boxes, n_boxes, x, y, x, y);
+      test_check_query(grid, boxes, n_boxes, x, y, g_rand_double_range(rand, -100, 700),
+          g_rand_double_range(rand, -100, 900));
+    }
+
+    /* queries on the corners of the boxes, where the comparisons are tight */
+    for (size_t j = 0; j < MIN(n_boxes, TEST_QUERIES); j++) {
+      const float* box = boxes + 4 * j;
+      test_check_nearest(grid, boxes, n_boxes, box[0], box[1]);
+      test_check_query(grid, boxes, n_boxes, box[0], box[1], box[2], box[3]);
+      test_check_query(grid, boxes, n_boxes, box[2], box[3], box[2], box[3]);
+    }
+
+    pdf_grid_free(grid);
+    g_free(boxes);
+  }
+
+  g_rand_free(rand);
+}
+
+/* All boxes in a single point, so that the grid has no extent */
+static void
+test_degenerate(void)
+{
+  const float boxes[] = { 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5 };
+  pdf_grid_t* grid    = pdf_grid_new(boxes, 3);
+
+  test_check_query(grid, boxes, 3, 5, 5, 5, 5);
+  test_check_query(grid, boxes, 3, 0, 0, 4, 4);
+  test_check_nearest(grid, boxes, 3, 5, 5);
+  test_check_nearest(grid, boxes, 3, -10, 20);
+
+  pdf_grid_free(grid);
+}
+
+static void
+test_empty(void)
+{
+  pdf_grid_t* grid = pdf_grid_new(NULL, 0);
+  GArray* result   = g_array_new(FALSE, FALSE, sizeof(guint32));
+  size_t index     = 0;
+
+  pdf_grid_query(grid, 0, 0, 100, 100, result);
+  g_assert_cmpuint(result->len, ==, 0);
+  g_assert_false(pdf_grid_nearest(grid, 0, 0, &index));
+
+  g_array_free(result, TRUE);
+  pdf_grid_free(grid);
+}
+
+int
+main(int argc, char* argv[])
+{
+  g_test_init(&argc, &argv, NULL);
+
+  g_test_add_func("/grid/random", test_random);
+  g_test_add_func("/grid/degenerate", test_degenerate);
+  g_test_add_func("/grid/empty", test_empty);
+
+  return g_test_run();
+}
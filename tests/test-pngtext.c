@@ -0,0 +1,207 @@
+/* See LICENSE file for license and copyright information */
+
+/* The chunks are checked with png_crc32, so the source is included to reach
+ * the static functions. */
+#include "pngtext.c"
+
+/* Seed of the random image, so that failures can be reproduced */
+#define TEST_SEED 0x9e6
+/* Size of the test image */
+#define TEST_WIDTH 37
+#define TEST_HEIGHT 23
+
+static const char* const test_text[] = {
+  "Thumb::URI", "file:///tmp/test.pdf#page=3",
+  "Thumb::MTime", "1700000000",
+  "Software", "zathura-pdf-poppler",
+  NULL
+};
+
+typedef struct test_reader_s {
+  const guint8* data; /**< PNG data */
+  gsize size; /**< Size of the data */
+  gsize offset; /**< Read position */
+} test_reader_t;
+
+static cairo_status_t
+test_read(void* data, unsigned char* buffer, unsigned int length)
+{
+  test_reader_t* reader = data;
+  if (length > reader->size - reader->offset) {
+    return CAIRO_STATUS_READ_ERROR;
+  }
+
+  memcpy(buffer, reader->data + reader->offset, length);
+  reader->offset += length;
+
+  return CAIRO_STATUS_SUCCESS;
+}
+
+/* Decodes PNG data with cairo */
+static cairo_surface_t*
+test_decode_png(const guint8* data, gsize size)
+{
+  test_reader_t reader = { data, size, 0 };
+  return cairo_image_surface_create_from_png_stream(test_read, &reader);
+}
+
+/* Returns an opaque image with random colors; opaque pixels survive the
+ * conversion from and to premultiplied alpha unchanged */
+static cairo_surface_t*
+test_create_surface(void)
+{
+  GRand* rand              = g_rand_new_with_seed(TEST_SEED);
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, TEST_WIDTH,
+      TEST_HEIGHT);
+  g_assert_cmpint(cairo_surface_status(surface), ==, CAIRO_STATUS_SUCCESS);
+
+  cairo_surface_flush(surface);
+  unsigned char* data = cairo_image_surface_get_data(surface);
+  const int stride    = cairo_image_surface_get_stride(surface);
+  for (int y = 0; y < TEST_HEIGHT; y++) {
+    guint32* row = (guint32*) (data + (size_t) y * stride);
+    for (int x = 0; x < TEST_WIDTH; x++) {
+      row[x] = 0xFF000000 | (g_rand_int(rand) & 0xFFFFFF);
+    }
+  }
+  cairo_surface_mark_dirty(surface);
+
+  g_rand_free(rand);
+
+  return surface;
+}
+
+/* Check value of the CRC used by PNG (ISO 3309) */
+static void
+test_crc(void)
+{
+  g_assert_cmphex(png_crc32((const guint8*) "123456789", 9), ==, 0xCBF43926);
+}
+
+/* Walks all chunks: every CRC matches, and the tEXt chunks follow the header
+ * in the given order, in front of the image data */
+static void
+test_chunks(void)
+{
+  cairo_surface_t* surface = test_create_surface();
+  GByteArray* png          = pdf_png_encode(surface, test_text);
+  g_assert_nonnull(png);
+
+  gsize offset       = PNG_SIGNATURE_SIZE;
+  unsigned int chunk = 0;
+  unsigned int text  = 0;
+  bool image_data    = false;
+  bool end           = false;
+  while (offset < png->len) {
+    g_assert_cmpuint(png->len - offset, >=, 12);
+    const guint32 length = png_read_uint(png->data + offset);
+    const guint8* type   = png->data + offset + 4;
+    const guint8* data   = png->data + offset + 8;
+    g_assert_cmpuint(length, <=, png->len - offset - 12);
+    g_assert_cmphex(png_read_uint(data + length), ==, png_crc32(type, length + 4));
+
+    if (chunk == 0) {
+      g_assert_cmpmem(type, 4, "IHDR", 4);
+      g_assert_cmpuint(offset + 12 + length, ==, PNG_HEADER_END);
+    } else if (memcmp(type, "tEXt", 4) == 0) {
+      g_assert_false(image_data);
+      g_assert_nonnull(test_text[2 * text]);
+
+      const gsize key_length = strlen(test_text[2 * text]) + 1;
+      g_assert_cmpmem(data, MIN(length, key_length), test_text[2 * text], key_length);
+      g_assert_cmpmem(data + key_length, length - key_length, test_text[2 * text + 1],
+          strlen(test_text[2 * text + 1]));
+      text++;
+    } else if (memcmp(type, "IDAT", 4) == 0) {
+      g_assert_cmpuint(text, ==, G_N_ELEMENTS(test_text) / 2);
+      image_data = true;
+    } else if (memcmp(type, "IEND", 4) == 0) {
+      end = true;
+    }
+
+    offset += length + 12;
+    chunk++;
+  }
+  g_assert_cmpuint(offset, ==, png->len);
+  g_assert_true(image_data);
+  g_assert_true(end);
+
+  g_byte_array_free(png, TRUE);
+  cairo_surface_destroy(surface);
+}
+
+/* The image decodes to the encoded pixels */
+static void
+test_decode(void)
+{
+  cairo_surface_t* surface = test_create_surface();
+  GByteArray* png          = pdf_png_encode(surface, test_text);
+  g_assert_nonnull(png);
+
+  cairo_surface_t* decoded = test_decode_png(png->data, png->len);
+  g_assert_cmpint(cairo_surface_status(decoded), ==, CAIRO_STATUS_SUCCESS);
+  g_assert_cmpint(cairo_image_surface_get_width(decoded), ==, TEST_WIDTH);
+  g_assert_cmpint(cairo_image_surface_get_height(decoded), ==, TEST_HEIGHT);
+
+  for (int y = 0; y < TEST_HEIGHT; y++) {
+    const unsigned char* expected = cairo_image_surface_get_data(surface) +
+      (size_t) y * cairo_image_surface_get_stride(surface);
+    const unsigned char* actual = cairo_image_surface_get_data(decoded) +
+      (size_t) y * cairo_image_surface_get_stride(decoded);
+    g_assert_cmpmem(actual, TEST_WIDTH * 4, expected, TEST_WIDTH * 4);
+  }
+
+  cairo_surface_t* truncated = test_decode_png(png->data, png->len / 2);
+  g_assert_cmpint(cairo_surface_status(truncated), !=, CAIRO_STATUS_SUCCESS);
+
+  cairo_surface_destroy(truncated);
+  cairo_surface_destroy(decoded);
+  g_byte_array_free(png, TRUE);
+  cairo_surface_destroy(surface);
+}
+
+static void
+test_has_text(void)
+{
+  cairo_surface_t* surface = test_create_surface();
+  GByteArray* png          = pdf_png_encode(surface, test_text);
+  g_assert_nonnull(png);
+
+  const char* const uri[]       = { "Thumb::URI", "file:///tmp/test.pdf#page=3", NULL };
+  const char* const other_uri[] = { "Thumb::URI", "file:///tmp/test.pdf#page=4", NULL };
+  const char* const prefix[]    = { "Thumb::URI", "file:///tmp/test.pdf", NULL };
+  const char* const missing[]   = { "Thumb::Size", "100", NULL };
+
+  g_assert_true(pdf_png_has_text(png->data, png->len, test_text));
+  g_assert_true(pdf_png_has_text(png->data, png->len, uri));
+  g_assert_false(pdf_png_has_text(png->data, png->len, other_uri));
+  g_assert_false(pdf_png_has_text(png->data, png->len, prefix));
+  g_assert_false(pdf_png_has_text(png->data, png->len, missing));
+
+  /* chunks that are cut off are not read */
+  g_assert_false(pdf_png_has_text(png->data, PNG_HEADER_END + 16, uri));
+  g_assert_false(pdf_png_has_text(png->data, PNG_SIGNATURE_SIZE, uri));
+  g_assert_false(pdf_png_has_text(NULL, 0, uri));
+
+  /* files without the chunks are rejected */
+  GByteArray* plain = pdf_png_encode(surface, NULL);
+  g_assert_nonnull(plain);
+  g_assert_false(pdf_png_has_text(plain->data, plain->len, uri));
+  g_byte_array_free(plain, TRUE);
+
+  g_byte_array_free(png, TRUE);
+  cairo_surface_destroy(surface);
+}
+
+int
+main(int argc, char* argv[])
+{
+  g_test_init(&argc, &argv, NULL);
+
+  g_test_add_func("/pngtext/crc", test_crc);
+  g_test_add_func("/pngtext/chunks", test_chunks);
+  g_test_add_func("/pngtext/decode", test_decode);
+  g_test_add_func("/pngtext/has-text", test_has_text);
+
+  return g_test_run();
+}
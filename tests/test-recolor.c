@@ -0,0 +1,147 @@
+/* See LICENSE file for license and copyright information */
+
+/* The vectorized loops of recolor_row are compared with recolor_row_scalar,
+ * so the source is included to reach the static functions. */
+#include "recolor.c"
+
+/* Seed of the random buffers, so that failures can be reproduced */
+#define TEST_SEED 0x5eed
+/* Number of random rows that are compared */
+#define TEST_ROWS 4096
+/* Maximal length of a row, enough for several vectors and every tail */
+#define TEST_MAX_LENGTH 67
+
+/* Returns a random premultiplied pixel. Fully transparent and opaque pixels
+ * are generated more often than others, since they are the common case. */
+static guint32
+test_random_pixel(GRand* rand)
+{
+  guint32 alpha = g_rand_int_range(rand, 0, 256);
+  switch (g_rand_int_range(rand, 0, 4)) {
+    case 0:
+      alpha = 0;
+      break;
+    case 1:
+      alpha = 255;
+      break;
+    default:
+      break;
+  }
+
+  guint32 pixel = alpha << 24;
+  for (unsigned int c = 0; c < 3; c++) {
+    pixel |= (guint32) g_rand_int_range(rand, 0, alpha + 1) << (8 * c);
+  }
+
+  return pixel;
+}
+
+static void
+test_random_recolor(GRand* rand, pdf_recolor_t* recolor)
+{
+  for (unsigned int c = 0; c < 3; c++) {
+    recolor->dark[c]  = g_rand_int_range(rand, 0, 256);
+    recolor->light[c] = g_rand_int_range(rand, 0, 256);
+  }
+}
+
+/* Recolors random rows with both paths and compares the results. Rows start
+ * at random offsets, so that unaligned loads are covered as well. */
+static void
+test_compare(guint32 alpha)
+{
+  GRand* rand     = g_rand_new_with_seed(TEST_SEED);
+  guint32* source = g_malloc(sizeof(guint32) * (TEST_MAX_LENGTH + 4));
+  guint32* vector = g_malloc(sizeof(guint32) * (TEST_MAX_LENGTH + 4));
+  guint32* scalar = g_malloc(sizeof(guint32) * (TEST_MAX_LENGTH + 4));
+  pdf_recolor_t recolor;
+
+  for (unsigned int row = 0; row < TEST_ROWS; row++) {
+    test_random_recolor(rand, &recolor);
+
+    const unsigned int offset = g_rand_int_range(rand, 0, 4);
+    const unsigned int length = g_rand_int_range(rand, 0, TEST_MAX_LENGTH + 1);
+    for (unsigned int i = 0; i < TEST_MAX_LENGTH + 4; i++) {
+      /* surfaces without alpha channel have undefined alpha bits */
+      source[i] = alpha != 0 ? g_rand_int(rand) : test_random_pixel(rand);
+    }
+    memcpy(vector, source, sizeof(guint32) * (TEST_MAX_LENGTH + 4));
+    memcpy(scalar, source, sizeof(guint32) * (TEST_MAX_LENGTH + 4));
+
+    recolor_row(&recolor, vector + offset, length, alpha);
+    recolor_row_scalar(&recolor, scalar + offset, length, alpha);
+
+    for (unsigned int i = 0; i < TEST_MAX_LENGTH + 4; i++) {
+      if (vector[i] != scalar[i]) {
+        g_test_message("row %u, pixel %u: source %08x, vectorized %08x, scalar %08x",
+            row, i, source[i], vector[i], scalar[i]);
+      }
+      g_assert_cmphex(vector[i], ==, scalar[i]);
+    }
+  }
+
+  g_free(scalar);
+  g_free(vector);
+  g_free(source);
+  g_rand_free(rand);
+}
+
+static void
+test_premultiplied(void)
+{
+  test_compare(0);
+}
+
+static void
+test_opaque(void)
+{
+  test_compare(0xFF000000);
+}
+
+/* Every channel value with every alpha value */
+static void
+test_exhaustive(void)
+{
+  const pdf_recolor_t recolor = { { 0x10, 0x80, 0xF0 }, { 0xFF, 0x33, 0x00 } };
+  guint32* vector             = g_malloc(sizeof(guint32) * 256);
+  guint32* scalar             = g_malloc(sizeof(guint32) * 256);
+
+  for (guint32 alpha = 0; alpha < 256; alpha++) {
+    for (guint32 value = 0; value <= alpha; value++) {
+      for (guint32 i = 0; i < 256; i++) {
+        /* vary the channels independently of each other */
+        const guint32 red   = value;
+        const guint32 green = (value + i) % (alpha + 1);
+        const guint32 blue  = (value * 7 + i * 3) % (alpha + 1);
+        vector[i]           = alpha << 24 | red << 16 | green << 8 | blue;
+      }
+      memcpy(scalar, vector, sizeof(guint32) * 256);
+
+      recolor_row(&recolor, vector, 256, 0);
+      recolor_row_scalar(&recolor, scalar, 256, 0);
+      g_assert_cmpmem(vector, sizeof(guint32) * 256, scalar, sizeof(guint32) * 256);
+    }
+  }
+
+  g_free(scalar);
+  g_free(vector);
+}
+
+int
+main(int argc, char* argv[])
+{
+#if defined(__AVX2__) && defined(__GNUC__)
+  /* the AVX2 build of the test cannot run on older processors */
+  if (__builtin_cpu_supports("avx2") == 0) {
+    return 77;
+  }
+#endif
+
+  g_test_init(&argc, &argv, NULL);
+
+  g_test_add_func("/recolor/premultiplied", test_premultiplied);
+  g_test_add_func("/recolor/opaque", test_opaque);
+  g_test_add_func("/recolor/exhaustive", test_exhaustive);
+
+  return g_test_run();
+}
@@ -1,8 +1,166 @@
 /* See LICENSE file for license and copyright information */
 
+#include <string.h>
+
+#include <gio/gio.h>
 #include <girara/utils.h>
 
 #include "plugin.h"
+#include "attachments.h"
+
+/* Size of the chunks written to the target file */
+#define ATTACHMENT_CHUNK_SIZE (64 * 1024)
+
+struct pdf_attachments_s {
+  GPtrArray* attachments; /**< All attachments in document order */
+  GArray* unique; /**< Positions of the first attachment of every name */
+  GHashTable* names; /**< Position + 1 of the first attachment by name */
+};
+
+typedef struct attachment_writer_s {
+  GOutputStream* stream; /**< Target stream */
+  char* buffer; /**< Pending data */
+  size_t length; /**< Length of the pending data */
+} attachment_writer_t;
+
+/* Reads the attachments of the document once and keeps them with the
+ * document. */
+static pdf_attachments_t*
+attachments_get(pdf_document_t* pdf_document)
+{
+  g_mutex_lock(&pdf_document->lock);
+  pdf_attachments_t* attachments = pdf_document->attachments;
+  g_mutex_unlock(&pdf_document->lock);
+
+  if (attachments != NULL) {
+    return attachments;
+  }
+
+  attachments              = g_malloc0(sizeof(pdf_attachments_t));
+  attachments->attachments = g_ptr_array_new_with_free_func(g_object_unref);
+  attachments->unique      = g_array_new(FALSE, FALSE, sizeof(guint));
+  attachments->names       = g_hash_table_new(g_str_hash, g_str_equal);
+
+  PopplerDocument* poppler_document = pdf_document->poppler_document;
+  if (poppler_document_has_attachments(poppler_document) == TRUE) {
+    GList* attachment_list = poppler_document_get_attachments(poppler_document);
+    for (GList* item = attachment_list; item != NULL; item = g_list_next(item)) {
+      PopplerAttachment* attachment = (PopplerAttachment*) item->data;
+      const guint position          = attachments->attachments->len;
+
+      /* the list's references are taken over by the array */
+      g_ptr_array_add(attachments->attachments, attachment);
+
+      if (attachment->name != NULL &&
+          g_hash_table_contains(attachments->names, attachment->name) == FALSE) {
+        g_hash_table_insert(attachments->names, attachment->name,
+            GUINT_TO_POINTER(position + 1));
+        g_array_append_val(attachments->unique, position);
+      }
+    }
+    g_list_free(attachment_list);
+  }
+
+  pdf_attachments_t* unused = NULL;
+
+  g_mutex_lock(&pdf_document->lock);
+  if (pdf_document->attachments == NULL) {
+    pdf_document->attachments = attachments;
+  } else {
+    /* the attachments were read in the meantime */
+    unused      = attachments;
+    attachments = pdf_document->attachments;
+  }
+  g_mutex_unlock(&pdf_document->lock);
+
+  pdf_attachments_free(unused);
+
+  return attachments;
+}
+
+static bool
+attachment_flush(attachment_writer_t* writer, GError** error)
+{
+  if (writer->length == 0) {
+    return true;
+  }
+
+  const gboolean written = g_output_stream_write_all(writer->stream,
+      writer->buffer, writer->length, NULL, NULL, error);
+  writer->length = 0;
+
+  return written == TRUE;
+}
+
+static gboolean
+attachment_write(const gchar* data, gsize count, gpointer user_data, GError** error)
+{
+  attachment_writer_t* writer = user_data;
+
+  while (count > 0) {
+    const size_t length = MIN(count, ATTACHMENT_CHUNK_SIZE - writer->length);
+    memcpy(writer->buffer + writer->length, data, length);
+    writer->length += length;
+    data           += length;
+    count          -= length;
+
+    if (writer->length == ATTACHMENT_CHUNK_SIZE && attachment_flush(writer, error) == false) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/* Streams an attachment into a file. The file is replaced only once the
+ * attachment has been written completely. */
+static zathura_error_t
+attachment_save(PopplerAttachment* attachment, const char* file)
+{
+  zathura_error_t ret = ZATHURA_ERROR_OK;
+  GError* error       = NULL;
+
+  GFile* gfile              = g_file_new_for_path(file);
+  GFileOutputStream* stream = g_file_replace(gfile, NULL, FALSE, G_FILE_CREATE_NONE, NULL, &error);
+  g_object_unref(gfile);
+
+  if (stream == NULL) {
+    girara_warning("Could not save attachment to '%s': %s", file, error->message);
+    g_error_free(error);
+    return ZATHURA_ERROR_UNKNOWN;
+  }
+
+  attachment_writer_t writer = {
+    .stream = G_OUTPUT_STREAM(stream),
+    .buffer = g_malloc(ATTACHMENT_CHUNK_SIZE),
+    .length = 0
+  };
+
+  if (poppler_attachment_save_to_callback(attachment, attachment_write, &writer, &error) == FALSE ||
+      attachment_flush(&writer, &error) == false) {
+    girara_warning("Could not save attachment to '%s': %s", file,
+        error != NULL ? error->message : "unknown error");
+    if (error != NULL) {
+      g_error_free(error);
+    }
+    ret = ZATHURA_ERROR_UNKNOWN;
+
+    /* closing with a cancelled cancellable keeps the original file */
+    GCancellable* cancellable = g_cancellable_new();
+    g_cancellable_cancel(cancellable);
+    g_output_stream_close(writer.stream, cancellable, NULL);
+    g_object_unref(cancellable);
+  } else if (g_output_stream_close(writer.stream, NULL, &error) == FALSE) {
+    girara_warning("Could not save attachment to '%s': %s", file, error->message);
+    g_error_free(error);
+    ret = ZATHURA_ERROR_UNKNOWN;
+  }
+
+  g_free(writer.buffer);
+  g_object_unref(stream);
+
+  return ret;
+}
 
 girara_list_t*
 pdf_document_attachments_get(zathura_document_t* document, void* data, zathura_error_t* error)
@@ -14,8 +172,9 @@ pdf_document_attachments_get(zathura_document_t* document, void* data, zathura_e
     return NULL;
   }
 
-  PopplerDocument* poppler_document = data;
-  if (poppler_document_has_attachments(poppler_document) == FALSE) {
+  pdf_document_t* pdf_document   = data;
+  pdf_attachments_t* attachments = attachments_get(pdf_document);
+  if (attachments->unique->len == 0) {
     girara_warning("PDF file has no attachments");
     if (error != NULL) {
       *error = ZATHURA_ERROR_UNKNOWN;
@@ -31,9 +190,9 @@ pdf_document_attachments_get(zathura_document_t* document, void* data, zathura_e
     return NULL;
   }
 
-  GList* attachment_list = poppler_document_get_attachments(poppler_document);
-  for (GList* attachments = attachment_list; attachments != NULL; attachments = g_list_next(attachments)) {
-    PopplerAttachment* attachment = (PopplerAttachment*) attachments->data;
+  for (guint i = 0; i < attachments->unique->len; i++) {
+    const guint position          = g_array_index(attachments->unique, guint, i);
+    PopplerAttachment* attachment = g_ptr_array_index(attachments->attachments, position);
     girara_list_append(res, g_strdup(attachment->name));
   }
 
@@ -44,26 +203,35 @@ zathura_error_t
 pdf_document_attachment_save(zathura_document_t* document,
     void* data, const char* attachmentname, const char* file)
 {
-  if (document == NULL || data == NULL) {
+  if (document == NULL || data == NULL || attachmentname == NULL || file == NULL) {
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  PopplerDocument* poppler_document = data;
-  if (poppler_document_has_attachments(poppler_document) == FALSE) {
+  pdf_document_t* pdf_document   = data;
+  pdf_attachments_t* attachments = attachments_get(pdf_document);
+  if (attachments->unique->len == 0) {
     girara_warning("PDF file has no attachments");
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
+  const guint position = GPOINTER_TO_UINT(g_hash_table_lookup(attachments->names, attachmentname));
+  if (position == 0) {
+    girara_warning("PDF file has no attachment '%s'", attachmentname);
+    return ZATHURA_ERROR_INVALID_ARGUMENTS;
+  }
 
-  GList* attachment_list = poppler_document_get_attachments(poppler_document);
-  for (GList* attachments = attachment_list; attachments != NULL; attachments = g_list_next(attachments)) {
-    PopplerAttachment* attachment = (PopplerAttachment*) attachments->data;
-    if (g_strcmp0(attachment->name, attachmentname) != 0) {
-      continue;
-    }
+  return attachment_save(g_ptr_array_index(attachments->attachments, position - 1), file);
+}
 
-    return poppler_attachment_save(attachment, file, NULL);
+void
+pdf_attachments_free(pdf_attachments_t* attachments)
+{
+  if (attachments == NULL) {
+    return;
   }
 
-  return ZATHURA_ERROR_OK;
+  g_hash_table_destroy(attachments->names);
+  g_array_free(attachments->unique, TRUE);
+  g_ptr_array_free(attachments->attachments, TRUE);
+  g_free(attachments);
 }
@@ -0,0 +1,17 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef ATTACHMENTS_H
+#define ATTACHMENTS_H
+
+#include "plugin.h"
+
+typedef struct pdf_attachments_s pdf_attachments_t;
+
+/**
+ * Frees the attachment index of a document
+ *
+ * @param attachments The index
+ */
+GIRARA_HIDDEN void pdf_attachments_free(pdf_attachments_t* attachments);
+
+#endif // ATTACHMENTS_H
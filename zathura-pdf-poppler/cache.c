@@ -0,0 +1,229 @@
+/* See LICENSE file for license and copyright information */
+
+#include <string.h>
+
+#include "cache.h"
+
+typedef struct pdf_render_cache_entry_s {
+  pdf_render_cache_key_t key; /**< Key of the entry */
+  cairo_surface_t* surface; /**< Cached surface */
+  size_t size; /**< Size of the surface in bytes */
+  GList* link; /**< Link in the LRU queue */
+} pdf_render_cache_entry_t;
+
+struct pdf_render_cache_s {
+  GHashTable* entries; /**< Entries by key */
+  GQueue lru; /**< Entries, most recently used first */
+  size_t budget; /**< Maximal size of all surfaces */
+  size_t size; /**< Size of all surfaces */
+  unsigned long hits; /**< Number of successful lookups */
+  unsigned long misses; /**< Number of failed lookups */
+  GMutex lock; /**< Protects the fields above */
+};
+
+/* Hashes the bits of a double, so that any finite value (including huge
+ * scales) can be hashed. Keys with NaN are never inserted, since they would
+ * not compare equal to themselves. */
+static guint
+cache_hash_double(double value)
+{
+  /* -0.0 compares equal to 0.0 and needs the same hash */
+  if (value == 0) {
+    value = 0;
+  }
+
+  guint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  return (guint) (bits ^ (bits >> 32));
+}
+
+static guint
+cache_key_hash(gconstpointer data)
+{
+  const pdf_render_cache_key_t* key = data;
+
+  guint hash = key->page;
+  hash = hash * 31 + cache_hash_double(key->matrix.xx);
+  hash = hash * 31 + cache_hash_double(key->matrix.yy);
+  hash = hash * 31 + cache_hash_double(key->matrix.xy);
+  hash = hash * 31 + cache_hash_double(key->matrix.yx);
+  hash = hash * 31 + key->area.x;
+  hash = hash * 31 + key->area.y;
+  hash = hash * 31 + key->area.width;
+  hash = hash * 31 + key->area.height;
+
+  return hash;
+}
+
+static gboolean
+cache_key_equal(gconstpointer a, gconstpointer b)
+{
+  const pdf_render_cache_key_t* key_a = a;
+  const pdf_render_cache_key_t* key_b = b;
+
+  return key_a->page == key_b->page &&
+    key_a->matrix.xx == key_b->matrix.xx &&
+    key_a->matrix.yx == key_b->matrix.yx &&
+    key_a->matrix.xy == key_b->matrix.xy &&
+    key_a->matrix.yy == key_b->matrix.yy &&
+    key_a->matrix.x0 == key_b->matrix.x0 &&
+    key_a->matrix.y0 == key_b->matrix.y0 &&
+    key_a->area.x == key_b->area.x &&
+    key_a->area.y == key_b->area.y &&
+    key_a->area.width == key_b->area.width &&
+    key_a->area.height == key_b->area.height;
+}
+
+static void
+cache_entry_free(void* data)
+{
+  pdf_render_cache_entry_t* entry = data;
+
+  cairo_surface_destroy(entry->surface);
+  g_free(entry);
+}
+
+/* Needs to be called with the cache lock held. */
+static void
+cache_evict(pdf_render_cache_t* cache, size_t required)
+{
+  while (cache->size + required > cache->budget) {
+    pdf_render_cache_entry_t* entry = g_queue_pop_tail(&cache->lru);
+    if (entry == NULL) {
+      break;
+    }
+
+    cache->size -= entry->size;
+    g_hash_table_remove(cache->entries, &entry->key);
+  }
+}
+
+pdf_render_cache_t*
+pdf_render_cache_new(size_t budget)
+{
+  pdf_render_cache_t* cache = g_malloc0(sizeof(pdf_render_cache_t));
+  cache->entries = g_hash_table_new_full(cache_key_hash, cache_key_equal,
+      NULL, cache_entry_free);
+  cache->budget = budget;
+  g_queue_init(&cache->lru);
+  g_mutex_init(&cache->lock);
+
+  return cache;
+}
+
+void
+pdf_render_cache_free(pdf_render_cache_t* cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+
+  g_queue_clear(&cache->lru);
+  g_hash_table_destroy(cache->entries);
+  g_mutex_clear(&cache->lock);
+  g_free(cache);
+}
+
+cairo_surface_t*
+pdf_render_cache_lookup(pdf_render_cache_t* cache, const pdf_render_cache_key_t* key)
+{
+  if (cache == NULL || key == NULL) {
+    return NULL;
+  }
+
+  g_mutex_lock(&cache->lock);
+
+  cairo_surface_t* surface        = NULL;
+  pdf_render_cache_entry_t* entry = g_hash_table_lookup(cache->entries, key);
+  if (entry != NULL) {
+    /* move to the front of the LRU queue */
+    g_queue_unlink(&cache->lru, entry->link);
+    g_queue_push_head_link(&cache->lru, entry->link);
+
+    surface = cairo_surface_reference(entry->surface);
+    cache->hits++;
+  } else {
+    cache->misses++;
+  }
+
+  g_mutex_unlock(&cache->lock);
+
+  return surface;
+}
+
+bool
+pdf_render_cache_contains(pdf_render_cache_t* cache, const pdf_render_cache_key_t* key)
+{
+  if (cache == NULL || key == NULL) {
+    return false;
+  }
+
+  g_mutex_lock(&cache->lock);
+  const bool contains = g_hash_table_contains(cache->entries, key);
+  g_mutex_unlock(&cache->lock);
+
+  return contains;
+}
+
+void
+pdf_render_cache_insert(pdf_render_cache_t* cache, const pdf_render_cache_key_t* key,
+    cairo_surface_t* surface)
+{
+  if (cache == NULL || key == NULL || surface == NULL) {
+    return;
+  }
+
+  const size_t size = (size_t) cairo_image_surface_get_stride(surface) *
+    cairo_image_surface_get_height(surface);
+  if (size > cache->budget) {
+    return;
+  }
+
+  pdf_render_cache_entry_t* entry = g_malloc0(sizeof(pdf_render_cache_entry_t));
+  memcpy(&entry->key, key, sizeof(pdf_render_cache_key_t));
+  entry->surface = cairo_surface_reference(surface);
+  entry->size    = size;
+
+  g_mutex_lock(&cache->lock);
+
+  /* replace an existing entry for the same key */
+  pdf_render_cache_entry_t* old_entry = g_hash_table_lookup(cache->entries, key);
+  if (old_entry != NULL) {
+    g_queue_delete_link(&cache->lru, old_entry->link);
+    cache->size -= old_entry->size;
+    g_hash_table_remove(cache->entries, key);
+  }
+
+  cache_evict(cache, size);
+
+  g_queue_push_head(&cache->lru, entry);
+  entry->link  = g_queue_peek_head_link(&cache->lru);
+  cache->size += size;
+  g_hash_table_insert(cache->entries, &entry->key, entry);
+
+  g_mutex_unlock(&cache->lock);
+}
+
+void
+pdf_render_cache_get_statistics(pdf_render_cache_t* cache, unsigned long* hits,
+    unsigned long* misses, size_t* size)
+{
+  if (cache == NULL) {
+    return;
+  }
+
+  g_mutex_lock(&cache->lock);
+
+  if (hits != NULL) {
+    *hits = cache->hits;
+  }
+  if (misses != NULL) {
+    *misses = cache->misses;
+  }
+  if (size != NULL) {
+    *size = cache->size;
+  }
+
+  g_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,80 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "plugin.h"
+
+typedef struct pdf_render_cache_s pdf_render_cache_t;
+
+/**
+ * Identifies a rendered area of a page
+ */
+typedef struct pdf_render_cache_key_s {
+  unsigned int page; /**< Page index */
+  cairo_matrix_t matrix; /**< Transformation from the page to the target
+                              (finite) */
+  cairo_rectangle_int_t area; /**< Rendered area on the target */
+} pdf_render_cache_key_t;
+
+/**
+ * Creates a cache for rendered surfaces. When the surfaces in the cache exceed
+ * the budget, the least recently used ones are evicted.
+ *
+ * @param budget Maximal size of all cached surfaces in bytes
+ * @return The cache
+ */
+GIRARA_HIDDEN pdf_render_cache_t* pdf_render_cache_new(size_t budget);
+
+/**
+ * Frees the cache and all cached surfaces
+ *
+ * @param cache The cache
+ */
+GIRARA_HIDDEN void pdf_render_cache_free(pdf_render_cache_t* cache);
+
+/**
+ * Looks up a rendered surface
+ *
+ * @param cache The cache
+ * @param key Key of the surface
+ * @return The surface (needs to be released with cairo_surface_destroy) or
+ *   NULL if it is not cached
+ */
+GIRARA_HIDDEN cairo_surface_t* pdf_render_cache_lookup(pdf_render_cache_t* cache,
+    const pdf_render_cache_key_t* key);
+
+/**
+ * Checks if a rendered surface is cached, without counting a hit or a miss
+ * and without marking the surface as used
+ *
+ * @param cache The cache
+ * @param key Key of the surface
+ * @return true if the surface is cached
+ */
+GIRARA_HIDDEN bool pdf_render_cache_contains(pdf_render_cache_t* cache,
+    const pdf_render_cache_key_t* key);
+
+/**
+ * Adds a rendered image surface to the cache. Surfaces that are larger than
+ * the budget are not cached.
+ *
+ * @param cache The cache
+ * @param key Key of the surface
+ * @param surface The surface
+ */
+GIRARA_HIDDEN void pdf_render_cache_insert(pdf_render_cache_t* cache,
+    const pdf_render_cache_key_t* key, cairo_surface_t* surface);
+
+/**
+ * Returns the statistics of the cache
+ *
+ * @param cache The cache
+ * @param hits Set to the number of successful lookups
+ * @param misses Set to the number of failed lookups
+ * @param size Set to the size of all cached surfaces in bytes
+ */
+GIRARA_HIDDEN void pdf_render_cache_get_statistics(pdf_render_cache_t* cache,
+    unsigned long* hits, unsigned long* misses, size_t* size);
+
+#endif // CACHE_H
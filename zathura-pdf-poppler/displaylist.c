@@ -0,0 +1,243 @@
+/* See LICENSE file for license and copyright information */
+
+#include "displaylist.h"
+#include "image.h"
+
+/* Rough average size of a recorded drawing operation in bytes, since cairo
+ * does not report the size of a recording surface */
+#define DISPLAY_LIST_OPERATION_SIZE 512
+
+typedef struct pdf_display_list_s {
+  unsigned int page; /**< Page index */
+  cairo_surface_t* surface; /**< Recording surface (NULL if the page is not recorded) */
+  size_t size; /**< Estimated size of the recording in bytes */
+  GList* link; /**< Link in the LRU queue (NULL without surface) */
+} pdf_display_list_t;
+
+struct pdf_display_lists_s {
+  GHashTable* entries; /**< Entries by page index */
+  GQueue lru; /**< Entries with surface, most recently used first */
+  size_t budget; /**< Maximal estimated size of all recordings */
+  size_t size; /**< Estimated size of all recordings */
+  unsigned long hits; /**< Number of replayed recordings */
+  unsigned long misses; /**< Number of recordings that were stored */
+  GMutex lock; /**< Protects the fields above */
+};
+
+static void
+display_list_free(void* data)
+{
+  pdf_display_list_t* entry = data;
+
+  if (entry->surface != NULL) {
+    cairo_surface_destroy(entry->surface);
+  }
+  g_free(entry);
+}
+
+/* Needs to be called with the lock held. */
+static void
+display_lists_remove(pdf_display_lists_t* lists, pdf_display_list_t* entry)
+{
+  if (entry->link != NULL) {
+    g_queue_delete_link(&lists->lru, entry->link);
+    lists->size -= entry->size;
+  }
+  g_hash_table_remove(lists->entries, GUINT_TO_POINTER(entry->page));
+}
+
+/* Needs to be called with the lock held. */
+static void
+display_lists_evict(pdf_display_lists_t* lists, size_t required)
+{
+  while (lists->size + required > lists->budget) {
+    GList* link = g_queue_peek_tail_link(&lists->lru);
+    if (link == NULL) {
+      break;
+    }
+
+    display_lists_remove(lists, link->data);
+  }
+}
+
+static void
+display_list_count_operation(cairo_surface_t* observer, cairo_surface_t* target,
+    void* data)
+{
+  (void) observer;
+  (void) target;
+
+  unsigned long* operations = data;
+  (*operations)++;
+}
+
+/* Records the drawing operations of the page. Returns false if the page
+ * cannot be rendered; surface is set to NULL if the page is not suited for
+ * recording. */
+static bool
+display_list_record(pdf_page_t* pdf_page, cairo_surface_t** surface, size_t* size)
+{
+  *surface = NULL;
+  *size    = 0;
+
+  /* a recording keeps a full resolution copy of every image */
+  GArray* images = g_array_new(FALSE, FALSE, sizeof(zathura_rectangle_t));
+  if (pdf_page_images_get_areas(pdf_page, images) == false) {
+    g_array_free(images, TRUE);
+    return false;
+  }
+
+  const bool has_images = images->len > 0;
+  g_array_free(images, TRUE);
+  if (has_images == true) {
+    return true;
+  }
+
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    return false;
+  }
+
+  cairo_rectangle_t extents = { 0, 0, 0, 0 };
+  poppler_page_get_size(poppler_page, &extents.width, &extents.height);
+
+  cairo_surface_t* recording = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA,
+      &extents);
+  cairo_surface_t* observer  = cairo_surface_create_observer(recording,
+      CAIRO_SURFACE_OBSERVER_NORMAL);
+
+  unsigned long operations = 0;
+  cairo_surface_observer_add_paint_callback(observer, display_list_count_operation, &operations);
+  cairo_surface_observer_add_mask_callback(observer, display_list_count_operation, &operations);
+  cairo_surface_observer_add_fill_callback(observer, display_list_count_operation, &operations);
+  cairo_surface_observer_add_stroke_callback(observer, display_list_count_operation, &operations);
+  cairo_surface_observer_add_glyphs_callback(observer, display_list_count_operation, &operations);
+
+  cairo_t* cairo = cairo_create(observer);
+  poppler_page_render(poppler_page, cairo);
+  const bool success = cairo_status(cairo) == CAIRO_STATUS_SUCCESS &&
+    cairo_surface_status(recording) == CAIRO_STATUS_SUCCESS;
+  cairo_destroy(cairo);
+  cairo_surface_destroy(observer);
+  g_object_unref(poppler_page);
+
+  if (success == false) {
+    cairo_surface_destroy(recording);
+    return false;
+  }
+
+  *surface = recording;
+  *size    = sizeof(pdf_display_list_t) + (size_t) operations * DISPLAY_LIST_OPERATION_SIZE;
+
+  return true;
+}
+
+pdf_display_lists_t*
+pdf_display_lists_new(size_t budget)
+{
+  pdf_display_lists_t* lists = g_malloc0(sizeof(pdf_display_lists_t));
+  lists->entries = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+      display_list_free);
+  lists->budget = budget;
+  g_queue_init(&lists->lru);
+  g_mutex_init(&lists->lock);
+
+  return lists;
+}
+
+void
+pdf_display_lists_free(pdf_display_lists_t* lists)
+{
+  if (lists == NULL) {
+    return;
+  }
+
+  g_queue_clear(&lists->lru);
+  g_hash_table_destroy(lists->entries);
+  g_mutex_clear(&lists->lock);
+  g_free(lists);
+}
+
+cairo_surface_t*
+pdf_display_lists_get(pdf_display_lists_t* lists, pdf_page_t* pdf_page)
+{
+  if (lists == NULL || pdf_page == NULL) {
+    return NULL;
+  }
+
+  g_mutex_lock(&lists->lock);
+  pdf_display_list_t* entry = g_hash_table_lookup(lists->entries,
+      GUINT_TO_POINTER(pdf_page->index));
+  if (entry != NULL) {
+    cairo_surface_t* surface = NULL;
+    if (entry->surface != NULL) {
+      /* move to the front of the LRU queue */
+      g_queue_unlink(&lists->lru, entry->link);
+      g_queue_push_head_link(&lists->lru, entry->link);
+
+      surface = cairo_surface_reference(entry->surface);
+      lists->hits++;
+    }
+    g_mutex_unlock(&lists->lock);
+
+    return surface;
+  }
+  g_mutex_unlock(&lists->lock);
+
+  /* record outside of the lock, other pages may be rendered meanwhile */
+  cairo_surface_t* surface = NULL;
+  size_t size              = 0;
+  if (display_list_record(pdf_page, &surface, &size) == false) {
+    return NULL;
+  }
+
+  g_mutex_lock(&lists->lock);
+  entry = g_hash_table_lookup(lists->entries, GUINT_TO_POINTER(pdf_page->index));
+  if (entry == NULL) {
+    entry       = g_malloc0(sizeof(pdf_display_list_t));
+    entry->page = pdf_page->index;
+
+    /* pages whose recording does not fit are remembered as not recorded,
+     * the recording is only used once */
+    if (surface != NULL && size <= lists->budget) {
+      display_lists_evict(lists, size);
+
+      entry->surface = cairo_surface_reference(surface);
+      entry->size    = size;
+      g_queue_push_head(&lists->lru, entry);
+      entry->link  = g_queue_peek_head_link(&lists->lru);
+      lists->size += size;
+      lists->misses++;
+    }
+
+    g_hash_table_insert(lists->entries, GUINT_TO_POINTER(entry->page), entry);
+  }
+  /* otherwise the page was recorded meanwhile and this recording is only
+   * used once */
+  g_mutex_unlock(&lists->lock);
+
+  return surface;
+}
+
+void
+pdf_display_lists_get_statistics(pdf_display_lists_t* lists, unsigned long* hits,
+    unsigned long* misses, size_t* size)
+{
+  if (lists == NULL) {
+    return;
+  }
+
+  g_mutex_lock(&lists->lock);
+
+  if (hits != NULL) {
+    *hits = lists->hits;
+  }
+  if (misses != NULL) {
+    *misses = lists->misses;
+  }
+  if (size != NULL) {
+    *size = lists->size;
+  }
+
+  g_mutex_unlock(&lists->lock);
+}
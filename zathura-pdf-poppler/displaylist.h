@@ -0,0 +1,54 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef DISPLAYLIST_H
+#define DISPLAYLIST_H
+
+#include "plugin.h"
+
+typedef struct pdf_display_lists_s pdf_display_lists_t;
+
+/**
+ * Creates a cache for display lists of pages. A display list is a cairo
+ * recording surface with the drawing operations of a page, which can be
+ * replayed at any scale or rotation without parsing the page again. When the
+ * estimated size of the lists exceeds the budget, the least recently used
+ * ones are evicted.
+ *
+ * @param budget Maximal estimated size of all display lists in bytes
+ * @return The cache
+ */
+GIRARA_HIDDEN pdf_display_lists_t* pdf_display_lists_new(size_t budget);
+
+/**
+ * Frees the cache and all display lists
+ *
+ * @param lists The cache
+ */
+GIRARA_HIDDEN void pdf_display_lists_free(pdf_display_lists_t* lists);
+
+/**
+ * Returns the display list of a page and records it if it is not cached.
+ * Pages with images are not recorded, since the recording would keep the
+ * decoded images.
+ *
+ * @param lists The cache
+ * @param pdf_page Internal page representation
+ * @return The recording surface in page coordinates (needs to be released
+ *   with cairo_surface_destroy) or NULL if the page is not recorded
+ */
+GIRARA_HIDDEN cairo_surface_t* pdf_display_lists_get(pdf_display_lists_t* lists,
+    pdf_page_t* pdf_page);
+
+/**
+ * Returns the statistics of the cache
+ *
+ * @param lists The cache
+ * @param hits Set to the number of replayed display lists
+ * @param misses Set to the number of display lists that were recorded and
+ *   stored; pages that are not recorded are not counted
+ * @param size Set to the estimated size of all display lists in bytes
+ */
+GIRARA_HIDDEN void pdf_display_lists_get_statistics(pdf_display_lists_t* lists,
+    unsigned long* hits, unsigned long* misses, size_t* size);
+
+#endif // DISPLAYLIST_H
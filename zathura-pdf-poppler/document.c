@@ -1,8 +1,205 @@
 /* See LICENSE file for license and copyright information */
 
+#ifdef HAVE_COPY_FILE_RANGE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#include <girara/utils.h>
+
 #include "plugin.h"
+#include "attachments.h"
+#include "cache.h"
+#include "displaylist.h"
+#include "pool.h"
+#include "recolor.h"
+#include "search.h"
+#include "text.h"
+#include "textcache.h"
+#include "thumbnail.h"
 #include "utils.h"
 
+#ifdef HAVE_POPPLER_NEW_FROM_BYTES
+/* Size of the region at the end of the file that is prefetched when mapping
+ * a document. It holds the trailer and usually the cross-reference data. */
+#define MAPPED_TAIL_SIZE (256 * 1024)
+
+static GBytes*
+pdf_document_map_file(const char* path, GError** error)
+{
+  GMappedFile* mapped_file = g_mapped_file_new(path, FALSE, error);
+  if (mapped_file == NULL) {
+    return NULL;
+  }
+
+  char* contents     = g_mapped_file_get_contents(mapped_file);
+  const gsize length = g_mapped_file_get_length(mapped_file);
+
+  if (contents != NULL && length > 0) {
+    /* poppler follows the cross-reference table to individual objects, so
+     * sequential read-ahead mostly pulls in data that is never used */
+    posix_madvise(contents, length, POSIX_MADV_RANDOM);
+
+    /* the trailer and the cross-reference data are needed right away */
+    const gsize page_size = sysconf(_SC_PAGESIZE);
+    const gsize offset    = ((length - MIN(length, MAPPED_TAIL_SIZE)) / page_size) * page_size;
+    posix_madvise(contents + offset, length - offset, POSIX_MADV_WILLNEED);
+  }
+
+  GBytes* bytes = g_mapped_file_get_bytes(mapped_file);
+  g_mapped_file_unref(mapped_file);
+
+  return bytes;
+}
+#endif
+
+#ifdef HAVE_POPPLER_NEW_FROM_STREAM
+static PopplerDocument*
+pdf_document_open_stream(const char* path, const char* password, GError** error)
+{
+  GFile* file              = g_file_new_for_path(path);
+  GFileInputStream* stream = g_file_read(file, NULL, error);
+  g_object_unref(file);
+  if (stream == NULL) {
+    return NULL;
+  }
+
+  /* with the length poppler seeks to the trailer instead of reading the
+   * whole stream, and only reads the objects it needs afterwards */
+  PopplerDocument* poppler_document = NULL;
+  GFileInfo* info = g_file_input_stream_query_info(stream, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+      NULL, error);
+  if (info != NULL) {
+    poppler_document = poppler_document_new_from_stream(G_INPUT_STREAM(stream),
+        g_file_info_get_size(info), password, NULL, error);
+    g_object_unref(info);
+  }
+
+  g_object_unref(stream);
+
+  return poppler_document;
+}
+#endif
+
+/* Size of the chunks read by the background prefetch */
+#define PREFETCH_CHUNK_SIZE (1024 * 1024)
+
+typedef struct pdf_prefetch_s {
+  int fd; /**< File descriptor of the document */
+  gint cancelled; /**< Set to stop the prefetch */
+  GThread* thread; /**< Prefetch thread */
+} pdf_prefetch_t;
+
+static gpointer
+pdf_document_prefetch_run(gpointer data)
+{
+  pdf_prefetch_t* prefetch = data;
+  char* buffer             = g_malloc(PREFETCH_CHUNK_SIZE);
+
+  off_t offset = 0;
+  while (g_atomic_int_get(&prefetch->cancelled) == 0) {
+    const ssize_t n = pread(prefetch->fd, buffer, PREFETCH_CHUNK_SIZE, offset);
+    if (n <= 0) {
+      break;
+    }
+    offset += n;
+  }
+
+  girara_debug("Prefetched %lld bytes", (long long) offset);
+  g_free(buffer);
+
+  return NULL;
+}
+
+/* Reads the file in the background, so that the parts of a linearized
+ * document behind the first page are in the page cache when poppler reads
+ * them. */
+static pdf_prefetch_t*
+pdf_document_prefetch_start(const char* path)
+{
+  const int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  pdf_prefetch_t* prefetch = g_malloc0(sizeof(pdf_prefetch_t));
+  prefetch->fd             = fd;
+
+  GError* error    = NULL;
+  prefetch->thread = g_thread_try_new("pdf-prefetch", pdf_document_prefetch_run,
+      prefetch, &error);
+  if (prefetch->thread == NULL) {
+    girara_warning("Could not start prefetch thread: %s", error->message);
+    g_error_free(error);
+    close(fd);
+    g_free(prefetch);
+    return NULL;
+  }
+
+  return prefetch;
+}
+
+static void
+pdf_document_prefetch_stop(pdf_prefetch_t* prefetch)
+{
+  if (prefetch == NULL) {
+    return;
+  }
+
+  g_atomic_int_set(&prefetch->cancelled, 1);
+  g_thread_join(prefetch->thread);
+  close(prefetch->fd);
+  g_free(prefetch);
+}
+
+static void
+pdf_document_destination_free(void* data)
+{
+  if (data != NULL) {
+    poppler_dest_free(data);
+  }
+}
+
+/* Creates the low priority workers on first use, one per processor. Only
+ * called while the document is opened. */
+static pdf_pool_t*
+pdf_document_get_background_pool(pdf_document_t* pdf_document)
+{
+  if (pdf_document->background_pool == NULL) {
+    pdf_document->background_pool = pdf_pool_new(pdf_document, g_get_num_processors(), true);
+  }
+
+  return pdf_document->background_pool;
+}
+
+static PopplerDocument*
+pdf_document_open_file(const char* path, const char* password, GError** error)
+{
+  /* format path */
+  char* file_uri = g_filename_to_uri(path, NULL, error);
+  if (file_uri == NULL) {
+    return NULL;
+  }
+
+  PopplerDocument* poppler_document = poppler_document_new_from_file(file_uri,
+      password, error);
+  g_free(file_uri);
+
+  return poppler_document;
+}
+
 zathura_error_t
 pdf_document_open(zathura_document_t* document)
 {
@@ -10,49 +207,152 @@ pdf_document_open(zathura_document_t* document)
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  zathura_error_t error = ZATHURA_ERROR_OK;
+  const char* path     = zathura_document_get_path(document);
+  const char* password = zathura_document_get_password(document);
+  const char* mode     = g_getenv("ZATHURA_PDF_POPPLER_OPEN_MODE");
 
-  /* format path */
-  GError* gerror  = NULL;
-  char* file_uri = g_filename_to_uri(zathura_document_get_path(document), NULL, NULL);
+  GError* gerror                    = NULL;
+  GBytes* bytes                     = NULL;
+  PopplerDocument* poppler_document = NULL;
+  bool streamed                     = false;
 
-  if (file_uri == NULL) {
-    error = ZATHURA_ERROR_UNKNOWN;
-    goto error_free;
+  if (mode != NULL && g_strcmp0(mode, "mmap") == 0) {
+#ifdef HAVE_POPPLER_NEW_FROM_BYTES
+    bytes = pdf_document_map_file(path, &gerror);
+    if (bytes != NULL) {
+      poppler_document = poppler_document_new_from_bytes(bytes, password, &gerror);
+    } else {
+      girara_warning("Could not map '%s': %s", path, gerror->message);
+      g_clear_error(&gerror);
+    }
+#else
+    girara_warning("Opening mapped files requires poppler >= 0.82");
+#endif
+  } else if (mode != NULL && g_strcmp0(mode, "stream") == 0) {
+#ifdef HAVE_POPPLER_NEW_FROM_STREAM
+    poppler_document = pdf_document_open_stream(path, password, &gerror);
+    streamed         = true;
+#else
+    girara_warning("Opening files as streams requires poppler >= 0.22");
+#endif
+  } else if (mode != NULL && g_strcmp0(mode, "file") != 0) {
+    girara_warning("Unknown open mode '%s'", mode);
   }
 
-  PopplerDocument* poppler_document = poppler_document_new_from_file(file_uri,
-      zathura_document_get_password(document), &gerror);
+  if (bytes == NULL && streamed == false) {
+    poppler_document = pdf_document_open_file(path, password, &gerror);
+  }
 
   if (poppler_document == NULL) {
+    zathura_error_t error = ZATHURA_ERROR_UNKNOWN;
     if (gerror != NULL && gerror->code == POPPLER_ERROR_ENCRYPTED) {
       error = ZATHURA_ERROR_INVALID_PASSWORD;
-    } else {
-      error = ZATHURA_ERROR_UNKNOWN;
     }
-    goto error_free;
+
+    if (gerror != NULL) {
+      g_error_free(gerror);
+    }
+
+    if (bytes != NULL) {
+      g_bytes_unref(bytes);
+    }
+
+    return error;
   }
 
-  zathura_document_set_data(document, poppler_document);
+  pdf_document_t* pdf_document   = g_malloc0(sizeof(pdf_document_t));
+  pdf_document->poppler_document = poppler_document;
+  pdf_document->path             = g_strdup(path);
+  pdf_document->password         = g_strdup(password);
+  pdf_document->bytes            = bytes;
+  pdf_document->lazy_pages       = pdf_env_get_bool("ZATHURA_PDF_POPPLER_LAZY_PAGES", false);
+  pdf_document->search_flags     = pdf_search_parse_flags(g_getenv("ZATHURA_PDF_POPPLER_SEARCH_MODE"));
+  pdf_document->image_max_size   = pdf_env_get_uint("ZATHURA_PDF_POPPLER_IMAGE_MAX_SIZE", 0);
+  pdf_document->recolor          = pdf_recolor_new(g_getenv("ZATHURA_PDF_POPPLER_RECOLOR"));
+  pdf_document->file_size        = -1;
+  pdf_document->number_of_pages  = poppler_document_get_n_pages(poppler_document);
+  pdf_document->page_heights     = g_malloc(sizeof(double) * MAX(pdf_document->number_of_pages, 1));
+  pdf_document->destinations     = g_hash_table_new_full(g_str_hash, g_str_equal,
+      g_free, pdf_document_destination_free);
+  pdf_document->prerendering     = g_hash_table_new(g_direct_hash, g_direct_equal);
+  g_mutex_init(&pdf_document->lock);
 
-  zathura_document_set_number_of_pages(document,
-      poppler_document_get_n_pages(poppler_document));
+  for (unsigned int i = 0; i < pdf_document->number_of_pages; i++) {
+    pdf_document->page_heights[i] = -1;
+  }
 
-  g_free(file_uri);
+  struct stat info;
+  if (stat(path, &info) == 0) {
+    pdf_document->file_size  = info.st_size;
+    pdf_document->file_mtime = (gint64) info.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) +
+      info.st_mtim.tv_nsec;
+  }
 
-  return ZATHURA_ERROR_OK;
+  /* so far poppler has only read what it needs to open the document, but
+   * zathura initializes every page next, which reads the objects of all
+   * pages; for linearized documents these lie behind the first page, so the
+   * file is read ahead in the background */
+  if (streamed == true && poppler_document_is_linearized(poppler_document) == TRUE) {
+    pdf_document->prefetch = pdf_document_prefetch_start(path);
+  }
 
-error_free:
+  /* least recently used poppler pages are dropped and created again when
+   * they are needed, which requires lazy pages */
+  pdf_document->max_resident_pages = pdf_env_get_uint("ZATHURA_PDF_POPPLER_MAX_RESIDENT_PAGES", 0);
+  if (pdf_document->max_resident_pages > 0) {
+    pdf_document->lazy_pages = true;
+  }
+  g_queue_init(&pdf_document->resident_pages);
+  g_mutex_init(&pdf_document->resident_lock);
+  g_cond_init(&pdf_document->resident_cond);
 
-  if (gerror != NULL) {
-    g_error_free(gerror);
+  const unsigned int n_threads = pdf_env_get_uint("ZATHURA_PDF_POPPLER_RENDER_THREADS", 0);
+  if (n_threads > 1) {
+    pdf_document->pool = pdf_pool_new(pdf_document, n_threads, false);
   }
 
-  if (file_uri != NULL) {
-    g_free(file_uri);
+  const unsigned int cache_size = pdf_env_get_uint("ZATHURA_PDF_POPPLER_RENDER_CACHE_SIZE", 0);
+  if (cache_size > 0) {
+    pdf_document->render_cache = pdf_render_cache_new((size_t) cache_size * 1024 * 1024);
   }
 
-  return error;
+  const unsigned int display_list_size =
+    pdf_env_get_uint("ZATHURA_PDF_POPPLER_DISPLAY_LIST_CACHE_SIZE", 0);
+  if (display_list_size > 0) {
+    pdf_document->display_lists = pdf_display_lists_new((size_t) display_list_size * 1024 * 1024);
+  }
+
+  /* thumbnails are rendered by their own low priority workers, so that they
+   * neither delay nor change how the displayed pages are rendered */
+  const unsigned int thumbnail_size = pdf_env_get_uint("ZATHURA_PDF_POPPLER_THUMBNAILS", 0);
+  if (thumbnail_size > 0) {
+    pdf_document->thumbnails = pdf_thumbnails_new(pdf_document,
+        pdf_document_get_background_pool(pdf_document), thumbnail_size);
+  }
+
+  /* the text cache is read into and written from the index */
+  const bool text_cache = pdf_env_get_bool("ZATHURA_PDF_POPPLER_TEXT_CACHE", false);
+  if (text_cache == true || pdf_env_get_bool("ZATHURA_PDF_POPPLER_TEXT_INDEX", false) == true) {
+    pdf_document->text_index = pdf_text_index_new(pdf_document->number_of_pages);
+  }
+
+  /* without a cached copy the text of all pages is extracted in the
+   * background, so the cache can be written when the document is closed;
+   * the text of encrypted documents is not written to the disk */
+  if (text_cache == true && pdf_document->password == NULL) {
+    pdf_document->text_cache = pdf_text_cache_get_filename(path);
+    if (pdf_document->text_cache != NULL &&
+        pdf_text_cache_load(pdf_document->text_index, pdf_document->text_cache) == false) {
+      pdf_text_index_extract(pdf_document->text_index,
+          pdf_document_get_background_pool(pdf_document));
+    }
+  }
+
+  zathura_document_set_data(document, pdf_document);
+
+  zathura_document_set_number_of_pages(document, pdf_document->number_of_pages);
+
+  return ZATHURA_ERROR_OK;
 }
 
 zathura_error_t
@@ -62,15 +362,258 @@ pdf_document_free(zathura_document_t* document, void* data)
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  PopplerDocument* poppler_document = data;
-  if (poppler_document != NULL) {
-    g_object_unref(poppler_document);
+  pdf_document_t* pdf_document = data;
+  if (pdf_document != NULL) {
+    pdf_document_prefetch_stop(pdf_document->prefetch);
+    /* prerendering workers insert into the render cache, background workers
+     * into the thumbnails and the text index */
+    pdf_pool_free(pdf_document->pool);
+    pdf_pool_free(pdf_document->background_pool);
+
+    if (pdf_document->render_cache != NULL) {
+      unsigned long hits   = 0;
+      unsigned long misses = 0;
+      pdf_render_cache_get_statistics(pdf_document->render_cache, &hits, &misses, NULL);
+      girara_debug("Render cache: %lu hits, %lu misses", hits, misses);
+      pdf_render_cache_free(pdf_document->render_cache);
+    }
+
+    if (pdf_document->display_lists != NULL) {
+      unsigned long hits   = 0;
+      unsigned long misses = 0;
+      pdf_display_lists_get_statistics(pdf_document->display_lists, &hits, &misses, NULL);
+      girara_debug("Display lists: %lu replayed, %lu recorded", hits, misses);
+      pdf_display_lists_free(pdf_document->display_lists);
+    }
+
+    pdf_thumbnails_free(pdf_document->thumbnails);
+    if (pdf_document->text_cache != NULL) {
+      pdf_text_cache_save(pdf_document->text_index, pdf_document->text_cache);
+      g_free(pdf_document->text_cache);
+    }
+    pdf_text_index_free(pdf_document->text_index);
+    g_object_unref(pdf_document->poppler_document);
+    g_free(pdf_document->path);
+    g_free(pdf_document->password);
+    if (pdf_document->bytes != NULL) {
+      g_bytes_unref(pdf_document->bytes);
+    }
+    g_hash_table_destroy(pdf_document->destinations);
+    g_hash_table_destroy(pdf_document->prerendering);
+    pdf_attachments_free(pdf_document->attachments);
+    pdf_recolor_free(pdf_document->recolor);
+    if (pdf_document->search_regex != NULL) {
+      g_regex_unref(pdf_document->search_regex);
+    }
+    g_free(pdf_document->page_heights);
+    g_mutex_clear(&pdf_document->resident_lock);
+    g_cond_clear(&pdf_document->resident_cond);
+    g_mutex_clear(&pdf_document->lock);
+    g_free(pdf_document);
     zathura_document_set_data(document, NULL);
   }
 
   return ZATHURA_ERROR_OK;
 }
 
+PopplerDocument*
+pdf_document_open_copy(pdf_document_t* pdf_document, GError** error)
+{
+  if (pdf_document == NULL) {
+    return NULL;
+  }
+
+#ifdef HAVE_POPPLER_NEW_FROM_BYTES
+  if (pdf_document->bytes != NULL) {
+    return poppler_document_new_from_bytes(pdf_document->bytes,
+        pdf_document->password, error);
+  }
+#endif
+
+  return pdf_document_open_file(pdf_document->path, pdf_document->password, error);
+}
+
+double
+pdf_document_get_page_height(pdf_document_t* pdf_document, unsigned int index)
+{
+  if (pdf_document == NULL || index >= pdf_document->number_of_pages) {
+    return 0;
+  }
+
+  g_mutex_lock(&pdf_document->lock);
+  double height = pdf_document->page_heights[index];
+  g_mutex_unlock(&pdf_document->lock);
+
+  if (height >= 0) {
+    return height;
+  }
+
+  PopplerPage* poppler_page = poppler_document_get_page(pdf_document->poppler_document, index);
+  if (poppler_page == NULL) {
+    return 0;
+  }
+
+  poppler_page_get_size(poppler_page, NULL, &height);
+  g_object_unref(poppler_page);
+
+  pdf_document_set_page_height(pdf_document, index, height);
+
+  return height;
+}
+
+void
+pdf_document_set_page_height(pdf_document_t* pdf_document, unsigned int index, double height)
+{
+  if (pdf_document == NULL || index >= pdf_document->number_of_pages) {
+    return;
+  }
+
+  g_mutex_lock(&pdf_document->lock);
+  pdf_document->page_heights[index] = height;
+  g_mutex_unlock(&pdf_document->lock);
+}
+
+const PopplerDest*
+pdf_document_find_dest(pdf_document_t* pdf_document, const char* name)
+{
+  if (pdf_document == NULL || name == NULL) {
+    return NULL;
+  }
+
+  g_mutex_lock(&pdf_document->lock);
+
+  PopplerDest* destination = NULL;
+  if (g_hash_table_lookup_extended(pdf_document->destinations, name, NULL,
+        (gpointer*) &destination) == FALSE) {
+    /* failed lookups are stored as well so that broken links are only
+     * resolved once */
+    destination = poppler_document_find_dest(pdf_document->poppler_document, name);
+    g_hash_table_insert(pdf_document->destinations, g_strdup(name), destination);
+  }
+
+  g_mutex_unlock(&pdf_document->lock);
+
+  return destination;
+}
+
+/* Size of the chunks of copies without kernel support */
+#define COPY_CHUNK_SIZE (1024 * 1024)
+/* Maximal size of a single kernel-side copy */
+#define COPY_RANGE_SIZE (1024 * 1024 * 1024)
+
+/* Copies the rest of the source to the destination through a buffer */
+static bool
+pdf_document_copy_chunked(int source, int destination)
+{
+  char* buffer = g_malloc(COPY_CHUNK_SIZE);
+  bool success = true;
+
+  while (success == true) {
+    const ssize_t n = read(source, buffer, COPY_CHUNK_SIZE);
+    if (n == 0) {
+      break;
+    } else if (n < 0) {
+      success = (errno == EINTR);
+      continue;
+    }
+
+    ssize_t written = 0;
+    while (success == true && written < n) {
+      const ssize_t w = write(destination, buffer + written, n - written);
+      if (w > 0) {
+        written += w;
+      } else if (w < 0 && errno != EINTR) {
+        success = false;
+      }
+    }
+  }
+
+  g_free(buffer);
+
+  return success;
+}
+
+/* Copies the source to the empty destination. The file system is asked to
+ * share the data (reflink) or to copy it without passing it through user
+ * space, before falling back to a buffered copy. */
+static bool
+pdf_document_copy_data(int source, int destination)
+{
+#ifdef FICLONE
+  if (ioctl(destination, FICLONE, source) == 0) {
+    return true;
+  }
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  while (true) {
+    const ssize_t n = copy_file_range(source, NULL, destination, NULL,
+        COPY_RANGE_SIZE, 0);
+    if (n == 0) {
+      return true;
+    } else if (n > 0 || errno == EINTR) {
+      continue;
+    } else if (errno != EXDEV && errno != ENOSYS && errno != EINVAL &&
+        errno != EOPNOTSUPP) {
+      return false;
+    }
+
+    /* not supported between these files, the offsets of both files are
+     * where the buffered copy continues */
+    break;
+  }
+#endif
+
+  return pdf_document_copy_chunked(source, destination);
+}
+
+/* Copies the file of the document to the given path. Returns false if the
+ * file has changed since the document was opened or could not be copied. */
+static bool
+pdf_document_copy_file(pdf_document_t* pdf_document, const char* path)
+{
+  if (pdf_document->file_size < 0) {
+    return false;
+  }
+
+  const int source = open(pdf_document->path, O_RDONLY | O_CLOEXEC);
+  if (source < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(source, &info) != 0 || info.st_size != pdf_document->file_size ||
+      (gint64) info.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) + info.st_mtim.tv_nsec !=
+      pdf_document->file_mtime) {
+    close(source);
+    return false;
+  }
+
+  /* the file would be truncated before it is read */
+  struct stat target;
+  if (stat(path, &target) == 0 && target.st_dev == info.st_dev &&
+      target.st_ino == info.st_ino) {
+    close(source);
+    return true;
+  }
+
+  const int destination = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (destination < 0) {
+    close(source);
+    return false;
+  }
+
+  posix_fadvise(source, 0, 0, POSIX_FADV_SEQUENTIAL);
+  bool success = pdf_document_copy_data(source, destination);
+
+  if (close(destination) != 0) {
+    success = false;
+  }
+  close(source);
+
+  return success;
+}
+
 zathura_error_t
 pdf_document_save_as(zathura_document_t* document, void* data, const char* path)
 {
@@ -78,15 +621,21 @@ pdf_document_save_as(zathura_document_t* document, void* data, const char* path)
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
+  pdf_document_t* pdf_document = data;
+
+  /* the plugin does not change documents, and poppler writes an unmodified
+   * document as an exact copy of its file, so the file is copied directly */
+  if (pdf_document_copy_file(pdf_document, path) == true) {
+    return ZATHURA_ERROR_OK;
+  }
+
   /* format path */
   char* file_uri = g_filename_to_uri(path, NULL, NULL);
   if (file_uri == NULL) {
     return ZATHURA_ERROR_UNKNOWN;
   }
 
-  PopplerDocument* poppler_document = data;
-
-  const gboolean ret = poppler_document_save(poppler_document, file_uri, NULL);
+  const gboolean ret = poppler_document_save(pdf_document->poppler_document, file_uri, NULL);
   g_free(file_uri);
 
   return (ret == TRUE ? ZATHURA_ERROR_OK : ZATHURA_ERROR_UNKNOWN);
@@ -0,0 +1,225 @@
+/* See LICENSE file for license and copyright information */
+
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "downscale.h"
+
+/* Source pixels covered by a target column */
+typedef struct downscale_span_s {
+  unsigned int first; /**< First source column */
+  unsigned int last; /**< Last source column */
+  float first_weight; /**< Coverage of the first column */
+  float last_weight; /**< Coverage of the last column (if not the first) */
+} downscale_span_t;
+
+static downscale_span_t*
+downscale_get_spans(unsigned int source, unsigned int target)
+{
+  downscale_span_t* spans = g_malloc(sizeof(downscale_span_t) * target);
+  const double scale      = (double) source / target;
+
+  for (unsigned int i = 0; i < target; i++) {
+    const double start = i * scale;
+    const double end   = i + 1 == target ? source : (i + 1) * scale;
+
+    spans[i].first = (unsigned int) start;
+    spans[i].last  = MIN((unsigned int) ceil(end) - 1, source - 1);
+    if (spans[i].first == spans[i].last) {
+      spans[i].first_weight = end - start;
+      spans[i].last_weight  = 0;
+    } else {
+      spans[i].first_weight = spans[i].first + 1 - start;
+      spans[i].last_weight  = end - spans[i].last;
+    }
+  }
+
+  return spans;
+}
+
+/* Averages a source row horizontally into four floats per target pixel. The
+ * vectorized loops below compute exactly the same values. */
+static void
+downscale_resample_row_scalar(const unsigned char* row, const downscale_span_t* spans,
+    unsigned int width, float* out)
+{
+  for (unsigned int x = 0; x < width; x++) {
+    const downscale_span_t* span = &spans[x];
+
+    float sum[4] = { 0, 0, 0, 0 };
+    for (unsigned int i = span->first; i <= span->last; i++) {
+      const float weight = i == span->first ? span->first_weight :
+        (i == span->last ? span->last_weight : 1.0f);
+      for (unsigned int c = 0; c < 4; c++) {
+        sum[c] += weight * row[4 * i + c];
+      }
+    }
+    memcpy(out + 4 * x, sum, sizeof(sum));
+  }
+}
+
+static void
+downscale_resample_row(const unsigned char* row, const downscale_span_t* spans,
+    unsigned int width, float* out)
+{
+  unsigned int x = 0;
+
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  for (; x < width; x++) {
+    const downscale_span_t* span = &spans[x];
+
+    __m128 sum = _mm_setzero_ps();
+    for (unsigned int i = span->first; i <= span->last; i++) {
+      const float weight = i == span->first ? span->first_weight :
+        (i == span->last ? span->last_weight : 1.0f);
+
+      int value = 0;
+      memcpy(&value, row + 4 * i, 4);
+      __m128i pixel = _mm_cvtsi32_si128(value);
+      pixel         = _mm_unpacklo_epi16(_mm_unpacklo_epi8(pixel, zero), zero);
+      sum           = _mm_add_ps(sum, _mm_mul_ps(_mm_cvtepi32_ps(pixel), _mm_set1_ps(weight)));
+    }
+    _mm_storeu_ps(out + 4 * x, sum);
+  }
+#endif
+
+  downscale_resample_row_scalar(row, spans + x, width - x, out + 4 * x);
+}
+
+static void
+downscale_accumulate_row_scalar(float* accumulator, const float* row, float weight,
+    unsigned int n)
+{
+  for (unsigned int i = 0; i < n; i++) {
+    accumulator[i] += weight * row[i];
+  }
+}
+
+static void
+downscale_accumulate_row(float* accumulator, const float* row, float weight,
+    unsigned int n)
+{
+  unsigned int i = 0;
+
+#ifdef __SSE2__
+  const __m128 factor = _mm_set1_ps(weight);
+  for (; i + 4 <= n; i += 4) {
+    const __m128 sum = _mm_add_ps(_mm_loadu_ps(accumulator + i),
+        _mm_mul_ps(_mm_loadu_ps(row + i), factor));
+    _mm_storeu_ps(accumulator + i, sum);
+  }
+#endif
+
+  downscale_accumulate_row_scalar(accumulator + i, row + i, weight, n - i);
+}
+
+/* Scales the accumulated channels and rounds them to the nearest integer,
+ * ties to even, which is what _mm_cvtps_epi32 does in the default rounding
+ * mode */
+static void
+downscale_store_row_scalar(const float* accumulator, float factor, unsigned int width,
+    unsigned char* out)
+{
+  for (unsigned int x = 0; x < width; x++) {
+    for (unsigned int c = 0; c < 4; c++) {
+      const long value = lrintf(accumulator[4 * x + c] * factor);
+      out[4 * x + c]   = CLAMP(value, 0, 255);
+    }
+  }
+}
+
+static void
+downscale_store_row(const float* accumulator, float factor, unsigned int width,
+    unsigned char* out)
+{
+  unsigned int x = 0;
+
+#ifdef __SSE2__
+  const __m128 scale = _mm_set1_ps(factor);
+  for (; x < width; x++) {
+    const __m128i value  = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(accumulator + 4 * x), scale));
+    const __m128i words  = _mm_packs_epi32(value, value);
+    const __m128i packed = _mm_packus_epi16(words, words);
+    const int pixel      = _mm_cvtsi128_si32(packed);
+    memcpy(out + 4 * x, &pixel, 4);
+  }
+#endif
+
+  downscale_store_row_scalar(accumulator + 4 * x, factor, width - x, out + 4 * x);
+}
+
+cairo_surface_t*
+pdf_image_downscale(cairo_surface_t* surface, unsigned int width, unsigned int height)
+{
+  if (surface == NULL || width == 0 || height == 0) {
+    return NULL;
+  }
+
+  const cairo_format_t format = cairo_image_surface_get_format(surface);
+  const int source_width      = cairo_image_surface_get_width(surface);
+  const int source_height     = cairo_image_surface_get_height(surface);
+
+  if ((format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24) ||
+      width > (unsigned int) source_width || height > (unsigned int) source_height) {
+    return NULL;
+  }
+
+  cairo_surface_t* target = cairo_image_surface_create(format, width, height);
+  if (cairo_surface_status(target) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(target);
+    return NULL;
+  }
+
+  cairo_surface_flush(surface);
+
+  const unsigned char* source_data = cairo_image_surface_get_data(surface);
+  const int source_stride          = cairo_image_surface_get_stride(surface);
+  unsigned char* target_data       = cairo_image_surface_get_data(target);
+  const int target_stride          = cairo_image_surface_get_stride(target);
+
+  /* premultiplied pixels can be averaged channel by channel */
+  downscale_span_t* spans = downscale_get_spans(source_width, width);
+  float* row              = g_malloc(sizeof(float) * 4 * width);
+  float* accumulator      = g_malloc0(sizeof(float) * 4 * width);
+  const double scale      = (double) source_height / height;
+  const float factor      = (float) (((double) width / source_width) * ((double) height / source_height));
+
+  /* every source row is resampled once and added to the target rows it
+   * overlaps */
+  unsigned int y = 0;
+  for (int source_y = 0; source_y < source_height && y < height; source_y++) {
+    downscale_resample_row(source_data + (size_t) source_y * source_stride, spans, width, row);
+
+    double position = source_y;
+    while (y < height) {
+      const double row_end = y + 1 == height ? source_height : (y + 1) * scale;
+      const double end     = MIN(source_y + 1, row_end);
+
+      if (end > position) {
+        downscale_accumulate_row(accumulator, row, end - position, 4 * width);
+        position = end;
+      }
+
+      if (source_y + 1 < row_end) {
+        break;
+      }
+
+      downscale_store_row(accumulator, factor, width, target_data + (size_t) y * target_stride);
+      memset(accumulator, 0, sizeof(float) * 4 * width);
+      y++;
+    }
+  }
+
+  g_free(accumulator);
+  g_free(row);
+  g_free(spans);
+
+  cairo_surface_mark_dirty(target);
+
+  return target;
+}
@@ -0,0 +1,20 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef DOWNSCALE_H
+#define DOWNSCALE_H
+
+#include "plugin.h"
+
+/**
+ * Scales a 32 bit image surface down by averaging the source pixels covered
+ * by every target pixel
+ *
+ * @param surface The image surface
+ * @param width Width of the result (at most the width of the surface)
+ * @param height Height of the result (at most the height of the surface)
+ * @return The scaled surface or NULL if an error occurred
+ */
+GIRARA_HIDDEN cairo_surface_t* pdf_image_downscale(cairo_surface_t* surface,
+    unsigned int width, unsigned int height);
+
+#endif // DOWNSCALE_H
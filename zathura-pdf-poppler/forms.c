@@ -2,6 +2,9 @@
 
 #include "plugin.h"
 
+/* zathura declares the function, but has no type for form fields that a
+ * plugin could return and never uses the result, so poppler's fields are not
+ * converted. */
 girara_list_t*
 pdf_page_form_fields_get(zathura_page_t* UNUSED(page), void* UNUSED(poppler_page),
     zathura_error_t* error)
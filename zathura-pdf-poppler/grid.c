@@ -0,0 +1,258 @@
+/* See LICENSE file for license and copyright information */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grid.h"
+
+/* Average number of boxes per cell the grid is sized for */
+#define GRID_BOXES_PER_CELL 4
+/* Maximal number of cells per row and column */
+#define GRID_MAX_CELLS 256
+
+struct pdf_grid_s {
+  float* boxes; /**< Boxes (x1, y1, x2, y2) */
+  size_t n_boxes; /**< Number of boxes */
+  double x; /**< Left edge of the grid */
+  double y; /**< Top edge of the grid */
+  double cell_width; /**< Width of a cell */
+  double cell_height; /**< Height of a cell */
+  int columns; /**< Number of columns */
+  int rows; /**< Number of rows */
+  guint32* offsets; /**< Start of the references of every cell in references
+                         (columns * rows + 1 entries) */
+  guint32* references; /**< Box indices by cell */
+};
+
+static int
+grid_column(const pdf_grid_t* grid, double x)
+{
+  const double column = floor((x - grid->x) / grid->cell_width);
+  return column < 0 ? 0 : (column >= grid->columns ? grid->columns - 1 : (int) column);
+}
+
+static int
+grid_row(const pdf_grid_t* grid, double y)
+{
+  const double row = floor((y - grid->y) / grid->cell_height);
+  return row < 0 ? 0 : (row >= grid->rows ? grid->rows - 1 : (int) row);
+}
+
+static int
+grid_compare_index(const void* a, const void* b)
+{
+  const guint32 index_a = *(const guint32*) a;
+  const guint32 index_b = *(const guint32*) b;
+
+  return index_a < index_b ? -1 : (index_a > index_b ? 1 : 0);
+}
+
+/* Returns the squared distance between a point and a box */
+static double
+grid_distance(const float* box, double x, double y)
+{
+  const double dx = MAX(MAX(MIN(box[0], box[2]) - x, x - MAX(box[0], box[2])), 0);
+  const double dy = MAX(MAX(MIN(box[1], box[3]) - y, y - MAX(box[1], box[3])), 0);
+
+  return dx * dx + dy * dy;
+}
+
+pdf_grid_t*
+pdf_grid_new(const float* boxes, size_t n_boxes)
+{
+  pdf_grid_t* grid = g_malloc0(sizeof(pdf_grid_t));
+  grid->n_boxes    = boxes != NULL ? n_boxes : 0;
+  grid->boxes      = g_malloc(sizeof(float) * 4 * MAX(grid->n_boxes, 1));
+  if (grid->n_boxes > 0) {
+    memcpy(grid->boxes, boxes, sizeof(float) * 4 * grid->n_boxes);
+  }
+
+  double x1 = 0;
+  double y1 = 0;
+  double x2 = 1;
+  double y2 = 1;
+  for (size_t i = 0; i < grid->n_boxes; i++) {
+    const float* box = grid->boxes + 4 * i;
+    x1 = i == 0 ? MIN(box[0], box[2]) : MIN(x1, MIN(box[0], box[2]));
+    y1 = i == 0 ? MIN(box[1], box[3]) : MIN(y1, MIN(box[1], box[3]));
+    x2 = i == 0 ? MAX(box[0], box[2]) : MAX(x2, MAX(box[0], box[2]));
+    y2 = i == 0 ? MAX(box[1], box[3]) : MAX(y2, MAX(box[1], box[3]));
+  }
+
+  const size_t n_cells = MAX(grid->n_boxes / GRID_BOXES_PER_CELL, 1);
+  const int side       = MIN((int) ceil(sqrt((double) n_cells)), GRID_MAX_CELLS);
+
+  grid->x           = x1;
+  grid->y           = y1;
+  grid->columns     = side;
+  grid->rows        = side;
+  grid->cell_width  = MAX((x2 - x1) / side, 1e-3);
+  grid->cell_height = MAX((y2 - y1) / side, 1e-3);
+
+  /* count the references of every cell, turn the counts into offsets and
+   * fill in the references */
+  guint32* counts = g_malloc0(sizeof(guint32) * (side * side + 1));
+  for (int pass = 0; pass < 2; pass++) {
+    for (size_t i = 0; i < grid->n_boxes; i++) {
+      const float* box   = grid->boxes + 4 * i;
+      const int column_1 = grid_column(grid, MIN(box[0], box[2]));
+      const int column_2 = grid_column(grid, MAX(box[0], box[2]));
+      const int row_1    = grid_row(grid, MIN(box[1], box[3]));
+      const int row_2    = grid_row(grid, MAX(box[1], box[3]));
+
+      for (int row = row_1; row <= row_2; row++) {
+        for (int column = column_1; column <= column_2; column++) {
+          const int cell = row * side + column;
+          if (pass == 0) {
+            counts[cell + 1]++;
+          } else {
+            grid->references[counts[cell]++] = i;
+          }
+        }
+      }
+    }
+
+    if (pass == 0) {
+      for (int cell = 0; cell < side * side; cell++) {
+        counts[cell + 1] += counts[cell];
+      }
+      grid->offsets    = g_malloc(sizeof(guint32) * (side * side + 1));
+      memcpy(grid->offsets, counts, sizeof(guint32) * (side * side + 1));
+      grid->references = g_malloc(sizeof(guint32) * MAX(counts[side * side], 1));
+    }
+  }
+  g_free(counts);
+
+  return grid;
+}
+
+void
+pdf_grid_free(pdf_grid_t* grid)
+{
+  if (grid == NULL) {
+    return;
+  }
+
+  g_free(grid->boxes);
+  g_free(grid->offsets);
+  g_free(grid->references);
+  g_free(grid);
+}
+
+void
+pdf_grid_query(pdf_grid_t* grid, double x1, double y1, double x2, double y2,
+    GArray* result)
+{
+  if (grid == NULL || result == NULL || grid->n_boxes == 0) {
+    return;
+  }
+
+  const double left   = MIN(x1, x2);
+  const double right  = MAX(x1, x2);
+  const double top    = MIN(y1, y2);
+  const double bottom = MAX(y1, y2);
+
+  const int column_1 = grid_column(grid, left);
+  const int column_2 = grid_column(grid, right);
+  const int row_1    = grid_row(grid, top);
+  const int row_2    = grid_row(grid, bottom);
+  const guint first  = result->len;
+
+  for (int row = row_1; row <= row_2; row++) {
+    for (int column = column_1; column <= column_2; column++) {
+      const int cell = row * grid->columns + column;
+      for (guint32 j = grid->offsets[cell]; j < grid->offsets[cell + 1]; j++) {
+        const guint32 index = grid->references[j];
+        const float* box    = grid->boxes + 4 * index;
+
+        if (MAX(box[0], box[2]) < left || MIN(box[0], box[2]) > right ||
+            MAX(box[1], box[3]) < top || MIN(box[1], box[3]) > bottom) {
+          continue;
+        }
+
+        /* a box in several cells is only reported by the first cell of its
+         * intersection with the queried rectangle */
+        if (column != MAX(column_1, grid_column(grid, MIN(box[0], box[2]))) ||
+            row != MAX(row_1, grid_row(grid, MIN(box[1], box[3])))) {
+          continue;
+        }
+
+        g_array_append_val(result, index);
+      }
+    }
+  }
+
+  /* sort the new entries by index */
+  if (result->len - first > 1) {
+    qsort(&g_array_index(result, guint32, first), result->len - first,
+        sizeof(guint32), grid_compare_index);
+  }
+}
+
+bool
+pdf_grid_nearest(pdf_grid_t* grid, double x, double y, size_t* index)
+{
+  if (grid == NULL || index == NULL || grid->n_boxes == 0) {
+    return false;
+  }
+
+  const int center_column = grid_column(grid, x);
+  const int center_row    = grid_row(grid, y);
+  const int max_ring      = MAX(grid->columns, grid->rows);
+
+  double best       = INFINITY;
+  size_t best_index = 0;
+
+  /* visit the cells in rings around the point until no unvisited box can be
+   * closer than the best one */
+  for (int ring = 0; ring <= max_ring; ring++) {
+    for (int row = center_row - ring; row <= center_row + ring; row++) {
+      if (row < 0 || row >= grid->rows) {
+        continue;
+      }
+
+      const bool edge_row = row == center_row - ring || row == center_row + ring;
+      const int step      = edge_row == true ? 1 : MAX(2 * ring, 1);
+
+      for (int column = center_column - ring; column <= center_column + ring; column += step) {
+        if (column < 0 || column >= grid->columns) {
+          continue;
+        }
+
+        const int cell = row * grid->columns + column;
+        for (guint32 j = grid->offsets[cell]; j < grid->offsets[cell + 1]; j++) {
+          const guint32 candidate = grid->references[j];
+          const double distance   = grid_distance(grid->boxes + 4 * candidate, x, y);
+          if (distance < best || (distance == best && candidate < best_index)) {
+            best       = distance;
+            best_index = candidate;
+          }
+        }
+      }
+    }
+
+    /* boxes that have not been visited lie outside the visited block */
+    double margin = INFINITY;
+    if (center_column - ring > 0) {
+      margin = MIN(margin, x - (grid->x + (center_column - ring) * grid->cell_width));
+    }
+    if (center_column + ring + 1 < grid->columns) {
+      margin = MIN(margin, grid->x + (center_column + ring + 1) * grid->cell_width - x);
+    }
+    if (center_row - ring > 0) {
+      margin = MIN(margin, y - (grid->y + (center_row - ring) * grid->cell_height));
+    }
+    if (center_row + ring + 1 < grid->rows) {
+      margin = MIN(margin, grid->y + (center_row + ring + 1) * grid->cell_height - y);
+    }
+
+    if (margin == INFINITY || best <= margin * margin) {
+      break;
+    }
+  }
+
+  *index = best_index;
+
+  return true;
+}
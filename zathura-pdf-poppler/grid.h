@@ -0,0 +1,54 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef GRID_H
+#define GRID_H
+
+#include "plugin.h"
+
+typedef struct pdf_grid_s pdf_grid_t;
+
+/**
+ * Creates a uniform grid over a set of boxes for fast spatial lookups. The
+ * grid covers the bounding box of all boxes and every box is referenced by
+ * the cells it overlaps.
+ *
+ * @param boxes Boxes given as x1, y1, x2, y2 (copied)
+ * @param n_boxes Number of boxes
+ * @return The grid
+ */
+GIRARA_HIDDEN pdf_grid_t* pdf_grid_new(const float* boxes, size_t n_boxes);
+
+/**
+ * Frees the grid
+ *
+ * @param grid The grid
+ */
+GIRARA_HIDDEN void pdf_grid_free(pdf_grid_t* grid);
+
+/**
+ * Finds the boxes that intersect a rectangle
+ *
+ * @param grid The grid
+ * @param x1 Left edge of the rectangle
+ * @param y1 Top edge of the rectangle
+ * @param x2 Right edge of the rectangle
+ * @param y2 Bottom edge of the rectangle
+ * @param result Array of guint32 the indices of the boxes are appended to in
+ *   ascending order
+ */
+GIRARA_HIDDEN void pdf_grid_query(pdf_grid_t* grid, double x1, double y1,
+    double x2, double y2, GArray* result);
+
+/**
+ * Finds the box that contains a point or is closest to it
+ *
+ * @param grid The grid
+ * @param x X coordinate of the point
+ * @param y Y coordinate of the point
+ * @param index Set to the index of the box
+ * @return false if the grid has no boxes
+ */
+GIRARA_HIDDEN bool pdf_grid_nearest(pdf_grid_t* grid, double x, double y,
+    size_t* index);
+
+#endif // GRID_H
@@ -1,10 +1,51 @@
 /* See LICENSE file for license and copyright information */
 
+#include <math.h>
+
 #include "plugin.h"
+#include "image.h"
+#include "downscale.h"
 #include "utils.h"
 
 static void pdf_zathura_image_free(void* image);
 
+/* Reads the image mapping of the page once and keeps it until the page is
+ * cleared. Returns false if the page could not be loaded. */
+static bool
+images_load(pdf_page_t* pdf_page)
+{
+  g_mutex_lock(&pdf_page->lock);
+  const bool loaded = pdf_page->image_mapping_loaded;
+  g_mutex_unlock(&pdf_page->lock);
+
+  if (loaded == true) {
+    return true;
+  }
+
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    return false;
+  }
+
+  GList* image_mapping = poppler_page_get_image_mapping(poppler_page);
+  g_object_unref(poppler_page);
+
+  g_mutex_lock(&pdf_page->lock);
+  if (pdf_page->image_mapping_loaded == false) {
+    pdf_page->image_mapping        = image_mapping;
+    pdf_page->image_mapping_loaded = true;
+    image_mapping                  = NULL;
+  }
+  g_mutex_unlock(&pdf_page->lock);
+
+  /* the mapping was read in the meantime */
+  if (image_mapping != NULL) {
+    poppler_page_free_image_mapping(image_mapping);
+  }
+
+  return true;
+}
+
 girara_list_t*
 pdf_page_images_get(zathura_page_t* page, void* data, zathura_error_t* error)
 {
@@ -12,27 +53,35 @@ pdf_page_images_get(zathura_page_t* page, void* data, zathura_error_t* error)
     if (error != NULL) {
       *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
     }
-    goto error_ret;
+    return NULL;
+  }
+
+  pdf_page_t* pdf_page = data;
+  if (images_load(pdf_page) == false) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_UNKNOWN;
+    }
+    return NULL;
   }
 
-  girara_list_t* list  = NULL;
-  GList* image_mapping = NULL;
+  /* the cached mapping is set once and only freed with the page */
+  g_mutex_lock(&pdf_page->lock);
+  GList* image_mapping = pdf_page->image_mapping;
+  g_mutex_unlock(&pdf_page->lock);
 
-  PopplerPage* poppler_page = data;
-  image_mapping = poppler_page_get_image_mapping(poppler_page);
-  if (image_mapping == NULL || g_list_length(image_mapping) == 0) {
+  if (image_mapping == NULL) {
     if (error != NULL) {
       *error = ZATHURA_ERROR_UNKNOWN;
     }
-    goto error_free;
+    return NULL;
   }
 
-  list = girara_list_new();
+  girara_list_t* list = girara_list_new();
   if (list == NULL) {
     if (error != NULL) {
       *error = ZATHURA_ERROR_OUT_OF_MEMORY;
     }
-    goto error_free;
+    return NULL;
   }
 
   girara_list_set_free_function(list, pdf_zathura_image_free);
@@ -57,23 +106,32 @@ pdf_page_images_get(zathura_page_t* page, void* data, zathura_error_t* error)
     girara_list_append(list, zathura_image);
   }
 
-  poppler_page_free_image_mapping(image_mapping);
-
   return list;
+}
 
-error_free:
+static cairo_surface_t*
+image_get_surface(pdf_page_t* pdf_page, zathura_image_t* image, zathura_error_t* error)
+{
+  gint* image_id = (gint*) image->data;
 
-  if (list != NULL) {
-    girara_list_free(list);
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_UNKNOWN;
+    }
+    return NULL;
   }
 
-  if (image_mapping != NULL) {
-    poppler_page_free_image_mapping(image_mapping);
+  cairo_surface_t* surface = poppler_page_get_image(poppler_page, *image_id);
+  g_object_unref(poppler_page);
+  if (surface == NULL) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_UNKNOWN;
+    }
+    return NULL;
   }
 
-error_ret:
-
-  return NULL;
+  return surface;
 }
 
 cairo_surface_t*
@@ -84,25 +142,93 @@ pdf_page_image_get_cairo(zathura_page_t* page, void* data,
     if (error != NULL) {
       *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
     }
-    goto error_ret;
+    return NULL;
   }
 
-  gint* image_id = (gint*) image->data;
+  pdf_page_t* pdf_page = data;
 
-  PopplerPage* poppler_page = data;
-  cairo_surface_t* surface = poppler_page_get_image(poppler_page, *image_id);
-  if (surface == NULL) {
+  const unsigned int max_size = pdf_page->document->image_max_size;
+  if (max_size > 0) {
+    return pdf_page_image_get_cairo_scaled(pdf_page, image, max_size, max_size, error);
+  }
+
+  return image_get_surface(pdf_page, image, error);
+}
+
+cairo_surface_t*
+pdf_page_image_get_cairo_scaled(pdf_page_t* pdf_page, zathura_image_t* image,
+    unsigned int max_width, unsigned int max_height, zathura_error_t* error)
+{
+  if (pdf_page == NULL || image == NULL || image->data == NULL ||
+      max_width == 0 || max_height == 0) {
     if (error != NULL) {
-      *error = ZATHURA_ERROR_UNKNOWN;
+      *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
     }
-    goto error_ret;
+    return NULL;
   }
 
-  return surface;
+  cairo_surface_t* surface = image_get_surface(pdf_page, image, error);
+  if (surface == NULL) {
+    return NULL;
+  }
+
+  const int width    = cairo_image_surface_get_width(surface);
+  const int height   = cairo_image_surface_get_height(surface);
+  const double scale = MIN((double) max_width / width, (double) max_height / height);
+  if (scale >= 1) {
+    return surface;
+  }
+
+  const unsigned int target_width  = CLAMP((int) round(width * scale), 1, width);
+  const unsigned int target_height = CLAMP((int) round(height * scale), 1, height);
 
-error_ret:
+  /* the full resolution surface is only needed until it is scaled down */
+  cairo_surface_t* scaled = pdf_image_downscale(surface, target_width, target_height);
+  cairo_surface_destroy(surface);
 
-  return NULL;
+  if (scaled == NULL && error != NULL) {
+    *error = ZATHURA_ERROR_OUT_OF_MEMORY;
+  }
+
+  return scaled;
+}
+
+bool
+pdf_page_images_get_areas(pdf_page_t* pdf_page, GArray* areas)
+{
+  if (pdf_page == NULL || areas == NULL || images_load(pdf_page) == false) {
+    return false;
+  }
+
+  g_mutex_lock(&pdf_page->lock);
+  for (GList* image = pdf_page->image_mapping; image != NULL; image = g_list_next(image)) {
+    PopplerImageMapping* poppler_image = (PopplerImageMapping*) image->data;
+
+    const zathura_rectangle_t area = {
+      .x1 = poppler_image->area.x1,
+      .y1 = poppler_image->area.y1,
+      .x2 = poppler_image->area.x2,
+      .y2 = poppler_image->area.y2
+    };
+    g_array_append_val(areas, area);
+  }
+  g_mutex_unlock(&pdf_page->lock);
+
+  return true;
+}
+
+void
+pdf_page_images_free(pdf_page_t* pdf_page)
+{
+  if (pdf_page == NULL) {
+    return;
+  }
+
+  if (pdf_page->image_mapping != NULL) {
+    poppler_page_free_image_mapping(pdf_page->image_mapping);
+    pdf_page->image_mapping = NULL;
+  }
+  pdf_page->image_mapping_loaded = false;
 }
 
 static void
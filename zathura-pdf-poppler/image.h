@@ -0,0 +1,41 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include "plugin.h"
+
+/**
+ * Returns an image of the page scaled down to fit into the given size. The
+ * aspect ratio is kept and images are never scaled up.
+ *
+ * @param pdf_page Internal page representation
+ * @param image The image
+ * @param max_width Maximal width of the result
+ * @param max_height Maximal height of the result
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return The cairo image surface or NULL if an error occurred
+ */
+GIRARA_HIDDEN cairo_surface_t* pdf_page_image_get_cairo_scaled(pdf_page_t* pdf_page,
+    zathura_image_t* image, unsigned int max_width, unsigned int max_height,
+    zathura_error_t* error);
+
+/**
+ * Appends the areas of all images of a page to an array. The image mapping
+ * is read once and kept until the page is cleared.
+ *
+ * @param pdf_page Internal page representation
+ * @param areas Array of zathura_rectangle_t
+ * @return true if the image mapping could be read
+ */
+GIRARA_HIDDEN bool pdf_page_images_get_areas(pdf_page_t* pdf_page, GArray* areas);
+
+/**
+ * Frees the cached image mapping of a page
+ *
+ * @param pdf_page Internal page representation
+ */
+GIRARA_HIDDEN void pdf_page_images_free(pdf_page_t* pdf_page);
+
+#endif // IMAGE_H
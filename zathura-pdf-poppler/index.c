@@ -3,7 +3,7 @@
 #include "plugin.h"
 #include "utils.h"
 
-static void build_index(PopplerDocument* poppler_document, girara_tree_node_t*
+static void build_index(pdf_document_t* pdf_document, girara_tree_node_t*
     root, PopplerIndexIter* iter);
 
 girara_tree_node_t*
@@ -16,8 +16,8 @@ pdf_document_index_generate(zathura_document_t* document, void* data, zathura_er
     return NULL;
   }
 
-  PopplerDocument* poppler_document = data;
-  PopplerIndexIter* iter = poppler_index_iter_new(poppler_document);
+  pdf_document_t* pdf_document = data;
+  PopplerIndexIter* iter       = poppler_index_iter_new(pdf_document->poppler_document);
 
   if (iter == NULL) {
     if (error != NULL) {
@@ -28,16 +28,16 @@ pdf_document_index_generate(zathura_document_t* document, void* data, zathura_er
 
   girara_tree_node_t* root = girara_node_new(zathura_index_element_new("ROOT"));
   // girara_node_set_free_function(root, (girara_free_function_t) zathura_index_element_free);
-  build_index(poppler_document, root, iter);
+  build_index(pdf_document, root, iter);
 
   poppler_index_iter_free(iter);
   return root;
 }
 
 static void
-build_index(PopplerDocument* poppler_document, girara_tree_node_t* root, PopplerIndexIter* iter)
+build_index(pdf_document_t* pdf_document, girara_tree_node_t* root, PopplerIndexIter* iter)
 {
-  if (poppler_document == NULL || root == NULL || iter == NULL) {
+  if (pdf_document == NULL || root == NULL || iter == NULL) {
     return;
   }
 
@@ -48,30 +48,32 @@ build_index(PopplerDocument* poppler_document, girara_tree_node_t* root, Poppler
       continue;
     }
 
-    gchar* markup = g_markup_escape_text(action->any.title, -1);
+    /* entries without a valid destination are skipped */
+    zathura_rectangle_t rect = { 0, 0, 0, 0 };
+    zathura_link_t* link     = poppler_link_to_zathura_link(pdf_document, action, rect);
+    if (link == NULL) {
+      poppler_action_free(action);
+      continue;
+    }
+
+    gchar* markup = g_markup_escape_text(action->any.title != NULL ? action->any.title : "", -1);
     zathura_index_element_t* index_element = zathura_index_element_new(markup);
 
     g_free(markup);
+    poppler_action_free(action);
 
     if (index_element == NULL) {
-      poppler_action_free(action);
+      zathura_link_free(link);
       continue;
     }
 
-    zathura_rectangle_t rect = { 0, 0, 0, 0 };
-    index_element->link = poppler_link_to_zathura_link(poppler_document, action, rect);
-    if (index_element->link == NULL) {
-      poppler_action_free(action);
-      continue;
-    }
-
-    poppler_action_free(action);
+    index_element->link = link;
 
     girara_tree_node_t* node = girara_node_append_data(root, index_element);
     PopplerIndexIter* child  = poppler_index_iter_get_child(iter);
 
     if (child != NULL) {
-      build_index(poppler_document, node, child);
+      build_index(pdf_document, node, child);
     }
 
     poppler_index_iter_free(child);
@@ -1,46 +1,45 @@
 /* See LICENSE file for license and copyright information */
 
 #include "plugin.h"
+#include "links.h"
 #include "utils.h"
 
-girara_list_t*
-pdf_page_links_get(zathura_page_t* page, void* data, zathura_error_t* error)
+static zathura_link_t*
+links_copy(zathura_link_t* link)
 {
-  if (page == NULL || data == NULL) {
-    if (error != NULL) {
-      *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
-    }
-    goto error_ret;
-  }
+  return zathura_link_new(zathura_link_get_type(link),
+      zathura_link_get_position(link), zathura_link_get_target(link));
+}
 
-  girara_list_t* list       = NULL;
-  GList* link_mapping       = NULL;
-  PopplerPage* poppler_page = data;
+/* Converts the links of the page once and keeps them with the page. Returns
+ * false if the page could not be loaded. */
+static bool
+links_load(pdf_page_t* pdf_page)
+{
+  g_mutex_lock(&pdf_page->lock);
+  const bool loaded = pdf_page->links != NULL;
+  g_mutex_unlock(&pdf_page->lock);
 
-  link_mapping = poppler_page_get_link_mapping(poppler_page);
-  if (link_mapping == NULL || g_list_length(link_mapping) == 0) {
-    if (error != NULL) {
-      *error = ZATHURA_ERROR_UNKNOWN;
-    }
-    goto error_free;
+  if (loaded == true) {
+    return true;
   }
-  link_mapping = g_list_reverse(link_mapping);
 
-  list = girara_list_new2((girara_free_function_t) zathura_link_free);
-  if (list == NULL) {
-    if (error != NULL) {
-      *error = ZATHURA_ERROR_OUT_OF_MEMORY;
-    }
-    goto error_free;
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    return false;
   }
 
-  zathura_document_t* zathura_document = (zathura_document_t*) zathura_page_get_document(page);
-  PopplerDocument* poppler_document    = zathura_document_get_data(zathura_document);
+  GList* link_mapping = poppler_page_get_link_mapping(poppler_page);
+  g_object_unref(poppler_page);
+  link_mapping = g_list_reverse(link_mapping);
+
+  pdf_document_t* pdf_document = pdf_page->document;
+  const double page_height     = pdf_document_get_page_height(pdf_document, pdf_page->index);
 
-  const double page_height = zathura_page_get_height(page);
+  GPtrArray* links = g_ptr_array_new_with_free_func((GDestroyNotify) zathura_link_free);
 
   for (GList* link = link_mapping; link != NULL; link = g_list_next(link)) {
-    PopplerLinkMapping* poppler_link       = (PopplerLinkMapping*) link->data;
+    PopplerLinkMapping* poppler_link = (PopplerLinkMapping*) link->data;
 
     /* extract position */
     const zathura_rectangle_t position = {
@@ -51,28 +50,91 @@ pdf_page_links_get(zathura_page_t* page, void* data, zathura_error_t* error)
     };
 
     zathura_link_t* zathura_link =
-      poppler_link_to_zathura_link(poppler_document, poppler_link->action,
+      poppler_link_to_zathura_link(pdf_document, poppler_link->action,
           position);
     if (zathura_link != NULL) {
-      girara_list_append(list, zathura_link);
+      g_ptr_array_add(links, zathura_link);
     }
   }
 
-  poppler_page_free_link_mapping(link_mapping);
+  if (link_mapping != NULL) {
+    poppler_page_free_link_mapping(link_mapping);
+  }
 
-  return list;
+  g_mutex_lock(&pdf_page->lock);
+  if (pdf_page->links == NULL) {
+    pdf_page->links = links;
+    links           = NULL;
+  }
+  g_mutex_unlock(&pdf_page->lock);
+
+  /* the links were loaded in the meantime */
+  if (links != NULL) {
+    g_ptr_array_free(links, TRUE);
+  }
+
+  return true;
+}
+
+girara_list_t*
+pdf_page_links_get(zathura_page_t* page, void* data, zathura_error_t* error)
+{
+  if (page == NULL || data == NULL) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+    }
+    return NULL;
+  }
 
-error_free:
+  pdf_page_t* pdf_page = data;
+  if (links_load(pdf_page) == false) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_UNKNOWN;
+    }
+    return NULL;
+  }
+
+  /* the cached links are set once and only freed with the page */
+  g_mutex_lock(&pdf_page->lock);
+  GPtrArray* links = pdf_page->links;
+  g_mutex_unlock(&pdf_page->lock);
+
+  if (links->len == 0) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_UNKNOWN;
+    }
+    return NULL;
+  }
 
-  if (list != NULL) {
-    girara_list_free(list);
+  /* zathura takes ownership of the returned links, so they are copied on
+   * every call */
+  girara_list_t* list = girara_list_new2((girara_free_function_t) zathura_link_free);
+  if (list == NULL) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_OUT_OF_MEMORY;
+    }
+    return NULL;
   }
 
-  if (link_mapping != NULL) {
-    poppler_page_free_link_mapping(link_mapping);
+  for (guint i = 0; i < links->len; i++) {
+    zathura_link_t* link = links_copy(g_ptr_array_index(links, i));
+    if (link != NULL) {
+      girara_list_append(list, link);
+    }
   }
 
-error_ret:
+  return list;
+}
 
-  return NULL;
+void
+pdf_page_links_free(pdf_page_t* pdf_page)
+{
+  if (pdf_page == NULL) {
+    return;
+  }
+
+  if (pdf_page->links != NULL) {
+    g_ptr_array_free(pdf_page->links, TRUE);
+    pdf_page->links = NULL;
+  }
 }
@@ -0,0 +1,15 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef LINKS_H
+#define LINKS_H
+
+#include "plugin.h"
+
+/**
+ * Frees the cached links of a page
+ *
+ * @param pdf_page Internal page representation
+ */
+GIRARA_HIDDEN void pdf_page_links_free(pdf_page_t* pdf_page);
+
+#endif // LINKS_H
@@ -16,7 +16,8 @@ pdf_document_get_information(zathura_document_t* document, void* data, zathura_e
     return NULL;
   }
 
-  PopplerDocument* poppler_document = data;
+  pdf_document_t* pdf_document      = data;
+  PopplerDocument* poppler_document = pdf_document->poppler_document;
   girara_list_t* list               = zathura_document_information_entry_list_new();
   if (list == NULL) {
     return NULL;
@@ -81,8 +82,13 @@ pdf_page_get_label(zathura_page_t* page, void* data, char** label)
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  PopplerPage* poppler_page = data;
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(data);
+  if (poppler_page == NULL) {
+    return ZATHURA_ERROR_UNKNOWN;
+  }
+
   *label = poppler_page_get_label(poppler_page);
+  g_object_unref(poppler_page);
 
   return ZATHURA_ERROR_OK;
 }
@@ -1,6 +1,9 @@
 /* See LICENSE file for license and copyright information */
 
 #include "plugin.h"
+#include "image.h"
+#include "links.h"
+#include "search.h"
 
 zathura_error_t
 pdf_page_init(zathura_page_t* page)
@@ -9,29 +12,47 @@ pdf_page_init(zathura_page_t* page)
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  zathura_document_t* document      = zathura_page_get_document(page);
-  PopplerDocument* poppler_document = zathura_document_get_data(document);
+  zathura_document_t* document = zathura_page_get_document(page);
+  pdf_document_t* pdf_document = zathura_document_get_data(document);
 
-  if (poppler_document == NULL) {
+  if (pdf_document == NULL) {
     return ZATHURA_ERROR_UNKNOWN;
   }
 
-  /* init poppler data */
-  PopplerPage* poppler_page = poppler_document_get_page(poppler_document, zathura_page_get_index(page));
+  const unsigned int index = zathura_page_get_index(page);
+
+  /* poppler-glib only exposes the page geometry through a PopplerPage, so a
+   * temporary one is used in lazy mode and dropped again afterwards. This
+   * only releases the wrapper and its text and annotation caches: poppler
+   * keeps its own page object in the catalog for the lifetime of the
+   * document, and every page has been loaded once it is opened. */
+  PopplerPage* poppler_page = poppler_document_get_page(pdf_document->poppler_document, index);
 
   if (poppler_page == NULL) {
-    g_free(poppler_page);
     return ZATHURA_ERROR_UNKNOWN;
   }
 
-  zathura_page_set_data(page, poppler_page);
-
   /* calculate dimensions */
   double width;
   double height;
   poppler_page_get_size(poppler_page, &width, &height);
   zathura_page_set_width(page, width);
   zathura_page_set_height(page, height);
+  pdf_document_set_page_height(pdf_document, index, height);
+
+  /* init plugin data */
+  pdf_page_t* pdf_page = g_malloc0(sizeof(pdf_page_t));
+  pdf_page->document   = pdf_document;
+  pdf_page->index      = index;
+  g_mutex_init(&pdf_page->lock);
+
+  if (pdf_document->lazy_pages == true) {
+    g_object_unref(poppler_page);
+  } else {
+    pdf_page->poppler_page = poppler_page;
+  }
+
+  zathura_page_set_data(page, pdf_page);
 
   return ZATHURA_ERROR_OK;
 }
@@ -43,10 +64,116 @@ pdf_page_clear(zathura_page_t* page, void* data)
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  PopplerPage* poppler_page = data;
-  if (poppler_page != NULL) {
-    g_object_unref(poppler_page);
+  pdf_page_t* pdf_page = data;
+  if (pdf_page != NULL) {
+    pdf_document_t* pdf_document = pdf_page->document;
+    g_mutex_lock(&pdf_document->resident_lock);
+    /* another thread may still be releasing the poppler page */
+    while (pdf_page->evicting > 0) {
+      g_cond_wait(&pdf_document->resident_cond, &pdf_document->resident_lock);
+    }
+    if (pdf_page->resident_link.data != NULL) {
+      g_queue_unlink(&pdf_document->resident_pages, &pdf_page->resident_link);
+      pdf_page->resident_link.data = NULL;
+    }
+    g_mutex_unlock(&pdf_document->resident_lock);
+
+    if (pdf_page->poppler_page != NULL) {
+      g_object_unref(pdf_page->poppler_page);
+    }
+    pdf_search_state_free(pdf_page->search_state);
+    pdf_page_links_free(pdf_page);
+    pdf_page_images_free(pdf_page);
+    g_mutex_clear(&pdf_page->lock);
+    g_free(pdf_page);
   }
 
   return ZATHURA_ERROR_OK;
 }
+
+/* Marks the page as most recently used and drops the poppler pages of the
+ * least recently used pages beyond the document's limit. This only releases
+ * the poppler-glib wrappers with their text and annotation caches: poppler
+ * keeps its own page objects and the fonts and streams of the document until
+ * it is closed, so memory is not bounded by the number of resident pages. */
+static void
+pdf_page_touch(pdf_page_t* pdf_page)
+{
+  pdf_document_t* pdf_document = pdf_page->document;
+  GList* evicted               = NULL;
+
+  g_mutex_lock(&pdf_document->resident_lock);
+  if (pdf_page->resident_link.data != NULL) {
+    g_queue_unlink(&pdf_document->resident_pages, &pdf_page->resident_link);
+  }
+  pdf_page->resident_link.data = pdf_page;
+  g_queue_push_head_link(&pdf_document->resident_pages, &pdf_page->resident_link);
+
+  /* evicted pages are not cleared before their poppler page is released */
+  while (pdf_document->resident_pages.length > pdf_document->max_resident_pages) {
+    GList* link        = g_queue_pop_tail_link(&pdf_document->resident_pages);
+    pdf_page_t* victim = link->data;
+    victim->evicting++;
+    evicted    = g_list_prepend(evicted, victim);
+    link->data = NULL;
+  }
+  g_mutex_unlock(&pdf_document->resident_lock);
+
+  if (evicted == NULL) {
+    return;
+  }
+
+  /* the page locks are not taken while the queue is locked; a page that is
+   * used again in the meantime is simply created again */
+  for (GList* link = evicted; link != NULL; link = g_list_next(link)) {
+    pdf_page_t* victim = link->data;
+
+    g_mutex_lock(&victim->lock);
+    PopplerPage* poppler_page = victim->poppler_page;
+    victim->poppler_page      = NULL;
+    g_mutex_unlock(&victim->lock);
+
+    /* users of the page hold their own reference */
+    if (poppler_page != NULL) {
+      g_object_unref(poppler_page);
+    }
+  }
+
+  g_mutex_lock(&pdf_document->resident_lock);
+  for (GList* link = evicted; link != NULL; link = g_list_next(link)) {
+    pdf_page_t* victim = link->data;
+    victim->evicting--;
+  }
+  g_cond_broadcast(&pdf_document->resident_cond);
+  g_mutex_unlock(&pdf_document->resident_lock);
+
+  g_list_free(evicted);
+}
+
+PopplerPage*
+pdf_page_get_poppler_page(pdf_page_t* pdf_page)
+{
+  if (pdf_page == NULL) {
+    return NULL;
+  }
+
+  g_mutex_lock(&pdf_page->lock);
+
+  if (pdf_page->poppler_page == NULL) {
+    pdf_page->poppler_page = poppler_document_get_page(
+        pdf_page->document->poppler_document, pdf_page->index);
+  }
+
+  PopplerPage* poppler_page = NULL;
+  if (pdf_page->poppler_page != NULL) {
+    poppler_page = g_object_ref(pdf_page->poppler_page);
+  }
+
+  g_mutex_unlock(&pdf_page->lock);
+
+  if (poppler_page != NULL && pdf_page->document->max_resident_pages > 0) {
+    pdf_page_touch(pdf_page);
+  }
+
+  return poppler_page;
+}
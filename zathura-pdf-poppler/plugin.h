@@ -14,6 +14,64 @@
 #include <zathura/document.h>
 #include <zathura/plugin-api.h>
 
+/**
+ * Internal document representation
+ */
+typedef struct pdf_document_s {
+  PopplerDocument* poppler_document; /**< Poppler document */
+  char* path; /**< Path of the file */
+  char* password; /**< Password of the file or NULL */
+  GBytes* bytes; /**< Mapped file contents (NULL unless opened in mmap mode) */
+  goffset file_size; /**< Size of the file when it was opened (-1 if unknown) */
+  gint64 file_mtime; /**< Modification time of the file in ns when it was opened */
+  struct pdf_prefetch_s* prefetch; /**< Background read of the file (NULL if none) */
+  struct pdf_pool_s* pool; /**< Worker pool (NULL if disabled) */
+  struct pdf_pool_s* background_pool; /**< Low priority worker pool for
+                                           thumbnails and text extraction
+                                           (NULL if unused) */
+  struct pdf_render_cache_s* render_cache; /**< Rendered surfaces (NULL if disabled) */
+  struct pdf_display_lists_s* display_lists; /**< Recorded pages (NULL if disabled) */
+  struct pdf_text_index_s* text_index; /**< Extracted page text (NULL if disabled) */
+  char* text_cache; /**< Path of the on-disk text cache (NULL if disabled) */
+  struct pdf_thumbnails_s* thumbnails; /**< Thumbnail cache writer (NULL if disabled) */
+  struct pdf_recolor_s* recolor; /**< Color mapping applied to rendered pages (NULL if disabled) */
+  unsigned int search_flags; /**< Search mode (see pdf_search_flags_t) */
+  GRegex* search_regex; /**< Expression of the last regular expression search */
+  bool lazy_pages; /**< Create poppler pages on first use */
+  unsigned int max_resident_pages; /**< Maximal number of poppler pages kept (0 if unlimited) */
+  GQueue resident_pages; /**< Pages with a poppler page, most recently used first */
+  GMutex resident_lock; /**< Protects resident_pages and the resident links and
+                             eviction counts of the pages */
+  GCond resident_cond; /**< Signalled when pages have been evicted */
+  unsigned int number_of_pages; /**< Number of pages */
+  double* page_heights; /**< Page heights by index (negative if unknown) */
+  GHashTable* destinations; /**< Resolved named destinations by name */
+  GHashTable* prerendering; /**< Indices of the pages queued for prerendering */
+  struct pdf_attachments_s* attachments; /**< Attachment index (NULL until requested) */
+  unsigned int image_max_size; /**< Maximal image width and height (0 if unlimited) */
+  GMutex lock; /**< Protects page_heights, destinations, prerendering,
+                    attachments and search_regex */
+} pdf_document_t;
+
+/**
+ * Internal page representation
+ */
+typedef struct pdf_page_s {
+  pdf_document_t* document; /**< The document the page belongs to */
+  unsigned int index; /**< Page index */
+  PopplerPage* poppler_page; /**< Poppler page (NULL until first use if lazy) */
+  GList resident_link; /**< Link in the document's resident pages (data is NULL
+                            if the page is not in the queue) */
+  unsigned int evicting; /**< Number of threads releasing the poppler page */
+  struct pdf_search_state_s* search_state; /**< Occurrences of the last search
+                                                term (NULL until searched) */
+  GPtrArray* links; /**< Converted links (NULL until requested) */
+  GList* image_mapping; /**< Image mapping (NULL until requested) */
+  bool image_mapping_loaded; /**< The image mapping has been read */
+  GMutex lock; /**< Protects poppler_page, search_state, links and
+                    image_mapping */
+} pdf_page_t;
+
 /**
  * Open a pdf document
  *
@@ -32,6 +90,51 @@ GIRARA_HIDDEN zathura_error_t pdf_document_open(zathura_document_t* document);
  */
 GIRARA_HIDDEN zathura_error_t pdf_document_free(zathura_document_t* document, void* poppler_document);
 
+/**
+ * Opens another poppler document for the file of the given document. The new
+ * document is read the same way as the original one and shares its mapping
+ * in mmap mode.
+ *
+ * @param pdf_document Internal document representation
+ * @param error Set if an error occurred
+ * @return The poppler document or NULL if an error occurred
+ */
+GIRARA_HIDDEN PopplerDocument* pdf_document_open_copy(pdf_document_t* pdf_document,
+    GError** error);
+
+/**
+ * Returns the height of a page. The height is looked up in the document's
+ * page table and the page is only loaded if it is not known yet.
+ *
+ * @param pdf_document Internal document representation
+ * @param index Page index
+ * @return Height of the page or 0 if the page does not exist
+ */
+GIRARA_HIDDEN double pdf_document_get_page_height(pdf_document_t* pdf_document,
+    unsigned int index);
+
+/**
+ * Stores the height of a page in the document's page table
+ *
+ * @param pdf_document Internal document representation
+ * @param index Page index
+ * @param height Height of the page
+ */
+GIRARA_HIDDEN void pdf_document_set_page_height(pdf_document_t* pdf_document,
+    unsigned int index, double height);
+
+/**
+ * Resolves a named destination. Results (including failed lookups) are
+ * cached for the lifetime of the document.
+ *
+ * @param pdf_document Internal document representation
+ * @param name Name of the destination
+ * @return The destination (owned by the document) or NULL if it does not
+ *   exist
+ */
+GIRARA_HIDDEN const PopplerDest* pdf_document_find_dest(pdf_document_t* pdf_document,
+    const char* name);
+
 /**
  * Initializes the page with the needed values
  *
@@ -50,6 +153,16 @@ GIRARA_HIDDEN zathura_error_t pdf_page_init(zathura_page_t* page);
  */
 GIRARA_HIDDEN zathura_error_t pdf_page_clear(zathura_page_t* page, void* poppler_page);
 
+/**
+ * Returns the poppler page of the given page and creates it if it has not
+ * been loaded yet
+ *
+ * @param pdf_page Internal page representation
+ * @return Poppler page (needs to be released with g_object_unref) or NULL if
+ *   an error occurred
+ */
+GIRARA_HIDDEN PopplerPage* pdf_page_get_poppler_page(pdf_page_t* pdf_page);
+
 /**
  * Saves the document to the given path
  *
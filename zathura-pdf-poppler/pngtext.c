@@ -0,0 +1,132 @@
+/* See LICENSE file for license and copyright information */
+
+#include <string.h>
+
+#include "pngtext.h"
+
+/* Size of the PNG signature and the IHDR chunk that starts every PNG file */
+#define PNG_SIGNATURE_SIZE 8
+#define PNG_HEADER_END (PNG_SIGNATURE_SIZE + 4 + 4 + 13 + 4)
+
+static guint32
+png_crc32(const guint8* data, gsize length)
+{
+  guint32 crc = 0xFFFFFFFF;
+  for (gsize i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (unsigned int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+
+  return ~crc;
+}
+
+static guint32
+png_read_uint(const guint8* data)
+{
+  guint32 value;
+  memcpy(&value, data, sizeof(guint32));
+  return GUINT32_FROM_BE(value);
+}
+
+static void
+png_append_uint(GByteArray* array, guint32 value)
+{
+  value = GUINT32_TO_BE(value);
+  g_byte_array_append(array, (const guint8*) &value, sizeof(guint32));
+}
+
+/* Appends a tEXt chunk with a key and a value */
+static void
+png_append_text(GByteArray* png, const char* key, const char* value)
+{
+  const gsize key_length   = strlen(key) + 1;
+  const gsize value_length = strlen(value);
+
+  png_append_uint(png, key_length + value_length);
+
+  const guint start = png->len;
+  g_byte_array_append(png, (const guint8*) "tEXt", 4);
+  g_byte_array_append(png, (const guint8*) key, key_length);
+  g_byte_array_append(png, (const guint8*) value, value_length);
+
+  png_append_uint(png, png_crc32(png->data + start, png->len - start));
+}
+
+static cairo_status_t
+png_write(void* data, const unsigned char* buffer, unsigned int length)
+{
+  g_byte_array_append(data, buffer, length);
+  return CAIRO_STATUS_SUCCESS;
+}
+
+/* Checks if a tEXt chunk in front of the image data has the key and value */
+static bool
+png_find_text(const guint8* data, gsize size, const char* key, const char* value)
+{
+  gsize offset = PNG_SIGNATURE_SIZE;
+  while (size - offset >= 12) {
+    const guint32 length = png_read_uint(data + offset);
+    const guint8* type   = data + offset + 4;
+    const guint8* chunk  = data + offset + 8;
+    if (length > size - offset - 12 || memcmp(type, "IDAT", 4) == 0) {
+      break;
+    }
+
+    if (memcmp(type, "tEXt", 4) == 0) {
+      const guint8* separator = memchr(chunk, '\0', length);
+      if (separator != NULL && strcmp((const char*) chunk, key) == 0) {
+        const char* found        = (const char*) separator + 1;
+        const gsize found_length = chunk + length - (separator + 1);
+        return found_length == strlen(value) && memcmp(found, value, found_length) == 0;
+      }
+    }
+
+    offset += length + 12;
+  }
+
+  return false;
+}
+
+GByteArray*
+pdf_png_encode(cairo_surface_t* surface, const char* const* text)
+{
+  if (surface == NULL) {
+    return NULL;
+  }
+
+  GByteArray* encoded = g_byte_array_new();
+  if (cairo_surface_write_to_png_stream(surface, png_write, encoded) != CAIRO_STATUS_SUCCESS ||
+      encoded->len < PNG_HEADER_END) {
+    g_byte_array_free(encoded, TRUE);
+    return NULL;
+  }
+
+  GByteArray* png = g_byte_array_sized_new(encoded->len + 256);
+  g_byte_array_append(png, encoded->data, PNG_HEADER_END);
+  for (const char* const* pair = text; pair != NULL && pair[0] != NULL && pair[1] != NULL; pair += 2) {
+    png_append_text(png, pair[0], pair[1]);
+  }
+  g_byte_array_append(png, encoded->data + PNG_HEADER_END, encoded->len - PNG_HEADER_END);
+  g_byte_array_free(encoded, TRUE);
+
+  return png;
+}
+
+bool
+pdf_png_has_text(const guint8* data, gsize size, const char* const* text)
+{
+  static const guint8 signature[PNG_SIGNATURE_SIZE] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+  if (data == NULL || size < PNG_HEADER_END || memcmp(data, signature, PNG_SIGNATURE_SIZE) != 0) {
+    return false;
+  }
+
+  for (const char* const* pair = text; pair != NULL && pair[0] != NULL && pair[1] != NULL; pair += 2) {
+    if (png_find_text(data, size, pair[0], pair[1]) == false) {
+      return false;
+    }
+  }
+
+  return true;
+}
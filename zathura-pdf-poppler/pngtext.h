@@ -0,0 +1,32 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef PNGTEXT_H
+#define PNGTEXT_H
+
+#include "plugin.h"
+
+/**
+ * Encodes an image surface as PNG with tEXt chunks. The chunks are placed
+ * right after the header, in front of the image data, so that they can be
+ * read without decoding the image.
+ *
+ * @param surface The image surface
+ * @param text Keys and values of the chunks, alternating and terminated by
+ *   NULL
+ * @return The PNG data or NULL if the surface could not be encoded
+ */
+GIRARA_HIDDEN GByteArray* pdf_png_encode(cairo_surface_t* surface,
+    const char* const* text);
+
+/**
+ * Checks the tEXt chunks in front of the image data of a PNG file
+ *
+ * @param data PNG data
+ * @param size Size of the data
+ * @param text Keys and values, alternating and terminated by NULL
+ * @return true if the file has a chunk with every key and its value
+ */
+GIRARA_HIDDEN bool pdf_png_has_text(const guint8* data, gsize size,
+    const char* const* text);
+
+#endif // PNGTEXT_H
@@ -0,0 +1,319 @@
+/* See LICENSE file for license and copyright information */
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <girara/utils.h>
+
+#include "pool.h"
+
+/* Nice value of the workers of background pools */
+#define POOL_BACKGROUND_NICE 19
+
+typedef struct pdf_pool_job_s {
+  pdf_pool_function_t function; /**< Job function */
+  void* data; /**< Job data */
+  pdf_pool_group_t* group; /**< Group of the job */
+  bool urgent; /**< Run before non-urgent jobs */
+} pdf_pool_job_t;
+
+typedef struct pdf_pool_worker_s {
+  pdf_pool_t* pool; /**< The pool */
+  unsigned int id; /**< Index of the worker */
+  GThread* thread; /**< Worker thread */
+  GQueue queue; /**< Queued jobs of the worker */
+} pdf_pool_worker_t;
+
+struct pdf_pool_s {
+  pdf_document_t* pdf_document; /**< The document */
+  pdf_pool_worker_t* workers; /**< Workers */
+  unsigned int n_workers; /**< Number of workers */
+  unsigned int next_worker; /**< Worker that gets the next job */
+  bool background; /**< Workers run with the lowest priority */
+  bool shutdown; /**< Set when the pool is freed */
+  GMutex lock; /**< Protects the queues and the fields above */
+  GCond cond; /**< Signalled when jobs are queued */
+};
+
+struct pdf_pool_group_s {
+  unsigned int pending; /**< Number of unfinished jobs */
+  GMutex lock; /**< Protects pending */
+  GCond cond; /**< Signalled when the last job finished */
+};
+
+static void
+pool_group_add(pdf_pool_group_t* group)
+{
+  g_mutex_lock(&group->lock);
+  group->pending++;
+  g_mutex_unlock(&group->lock);
+}
+
+static void
+pool_group_done(pdf_pool_group_t* group)
+{
+  g_mutex_lock(&group->lock);
+  if (--group->pending == 0) {
+    g_cond_broadcast(&group->cond);
+  }
+  g_mutex_unlock(&group->lock);
+}
+
+static void
+pool_run_job(pdf_pool_job_t* job, PopplerDocument* poppler_document)
+{
+  job->function(poppler_document, job->data);
+
+  if (job->group != NULL) {
+    pool_group_done(job->group);
+  }
+
+  g_free(job);
+}
+
+/* Needs to be called with the pool lock held. */
+static pdf_pool_job_t*
+pool_take_job(pdf_pool_t* pool, pdf_pool_worker_t* worker)
+{
+  pdf_pool_job_t* job = g_queue_pop_head(&worker->queue);
+  if (job != NULL) {
+    return job;
+  }
+
+  /* steal urgent jobs first ... */
+  for (unsigned int i = 1; i < pool->n_workers; i++) {
+    pdf_pool_worker_t* victim = &pool->workers[(worker->id + i) % pool->n_workers];
+    pdf_pool_job_t* head      = g_queue_peek_head(&victim->queue);
+    if (head != NULL && head->urgent == true) {
+      return g_queue_pop_head(&victim->queue);
+    }
+  }
+
+  /* ... and then from the back of the other queues */
+  for (unsigned int i = 1; i < pool->n_workers; i++) {
+    pdf_pool_worker_t* victim = &pool->workers[(worker->id + i) % pool->n_workers];
+    job = g_queue_pop_tail(&victim->queue);
+    if (job != NULL) {
+      return job;
+    }
+  }
+
+  return NULL;
+}
+
+static gpointer
+pool_worker_thread(gpointer data)
+{
+  pdf_pool_worker_t* worker         = data;
+  pdf_pool_t* pool                  = worker->pool;
+  PopplerDocument* poppler_document = NULL;
+  bool open_failed                  = false;
+
+#ifdef __linux__
+  /* on Linux the nice value belongs to the thread, not the process */
+  if (pool->background == true &&
+      setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), POOL_BACKGROUND_NICE) != 0) {
+    girara_debug("Could not lower the priority of a worker thread");
+  }
+#endif
+
+  g_mutex_lock(&pool->lock);
+  while (pool->shutdown == false) {
+    pdf_pool_job_t* job = pool_take_job(pool, worker);
+    if (job == NULL) {
+      g_cond_wait(&pool->cond, &pool->lock);
+      continue;
+    }
+    g_mutex_unlock(&pool->lock);
+
+    /* the document is opened by the worker itself when it is needed */
+    if (poppler_document == NULL && open_failed == false) {
+      GError* error    = NULL;
+      poppler_document = pdf_document_open_copy(pool->pdf_document, &error);
+      if (poppler_document == NULL) {
+        girara_warning("Worker could not open document: %s",
+            error != NULL ? error->message : "unknown error");
+        g_clear_error(&error);
+        open_failed = true;
+      }
+    }
+
+    pool_run_job(job, poppler_document);
+
+    g_mutex_lock(&pool->lock);
+  }
+  g_mutex_unlock(&pool->lock);
+
+  if (poppler_document != NULL) {
+    g_object_unref(poppler_document);
+  }
+
+  return NULL;
+}
+
+pdf_pool_t*
+pdf_pool_new(pdf_document_t* pdf_document, unsigned int n_workers, bool background)
+{
+  if (pdf_document == NULL || n_workers == 0) {
+    return NULL;
+  }
+
+  pdf_pool_t* pool   = g_malloc0(sizeof(pdf_pool_t));
+  pool->pdf_document = pdf_document;
+  pool->background   = background;
+  pool->workers      = g_malloc0(sizeof(pdf_pool_worker_t) * n_workers);
+  g_mutex_init(&pool->lock);
+  g_cond_init(&pool->cond);
+
+  /* workers only look at n_workers once the lock is released */
+  g_mutex_lock(&pool->lock);
+  for (unsigned int i = 0; i < n_workers; i++) {
+    pdf_pool_worker_t* worker = &pool->workers[pool->n_workers];
+    worker->pool = pool;
+    worker->id   = pool->n_workers;
+    g_queue_init(&worker->queue);
+
+    GError* error  = NULL;
+    worker->thread = g_thread_try_new("pdf-poppler-worker", pool_worker_thread,
+        worker, &error);
+    if (worker->thread == NULL) {
+      girara_warning("Could not start worker thread: %s", error->message);
+      g_error_free(error);
+      break;
+    }
+
+    pool->n_workers++;
+  }
+  g_mutex_unlock(&pool->lock);
+
+  if (pool->n_workers == 0) {
+    pdf_pool_free(pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+void
+pdf_pool_free(pdf_pool_t* pool)
+{
+  if (pool == NULL) {
+    return;
+  }
+
+  /* take the queued jobs out of the queues and stop the workers */
+  GQueue discarded = G_QUEUE_INIT;
+
+  g_mutex_lock(&pool->lock);
+  pool->shutdown = true;
+  for (unsigned int i = 0; i < pool->n_workers; i++) {
+    pdf_pool_job_t* job = NULL;
+    while ((job = g_queue_pop_head(&pool->workers[i].queue)) != NULL) {
+      g_queue_push_tail(&discarded, job);
+    }
+  }
+  g_cond_broadcast(&pool->cond);
+  g_mutex_unlock(&pool->lock);
+
+  for (unsigned int i = 0; i < pool->n_workers; i++) {
+    g_thread_join(pool->workers[i].thread);
+  }
+
+  /* give discarded jobs the chance to release their data */
+  pdf_pool_job_t* job = NULL;
+  while ((job = g_queue_pop_head(&discarded)) != NULL) {
+    pool_run_job(job, NULL);
+  }
+
+  g_cond_clear(&pool->cond);
+  g_mutex_clear(&pool->lock);
+  g_free(pool->workers);
+  g_free(pool);
+}
+
+unsigned int
+pdf_pool_get_size(pdf_pool_t* pool)
+{
+  if (pool == NULL) {
+    return 0;
+  }
+
+  return pool->n_workers;
+}
+
+void
+pdf_pool_push(pdf_pool_t* pool, pdf_pool_group_t* group,
+    pdf_pool_function_t function, void* data, bool urgent)
+{
+  if (pool == NULL || function == NULL) {
+    return;
+  }
+
+  pdf_pool_job_t* job = g_malloc0(sizeof(pdf_pool_job_t));
+  job->function       = function;
+  job->data           = data;
+  job->group          = group;
+  job->urgent         = urgent;
+
+  if (group != NULL) {
+    pool_group_add(group);
+  }
+
+  g_mutex_lock(&pool->lock);
+  if (pool->shutdown == true) {
+    g_mutex_unlock(&pool->lock);
+    pool_run_job(job, NULL);
+    return;
+  }
+
+  pdf_pool_worker_t* worker = &pool->workers[pool->next_worker];
+  pool->next_worker         = (pool->next_worker + 1) % pool->n_workers;
+
+  if (urgent == true) {
+    g_queue_push_head(&worker->queue, job);
+  } else {
+    g_queue_push_tail(&worker->queue, job);
+  }
+
+  g_cond_signal(&pool->cond);
+  g_mutex_unlock(&pool->lock);
+}
+
+pdf_pool_group_t*
+pdf_pool_group_new(void)
+{
+  pdf_pool_group_t* group = g_malloc0(sizeof(pdf_pool_group_t));
+  g_mutex_init(&group->lock);
+  g_cond_init(&group->cond);
+
+  return group;
+}
+
+void
+pdf_pool_group_wait(pdf_pool_group_t* group)
+{
+  if (group == NULL) {
+    return;
+  }
+
+  g_mutex_lock(&group->lock);
+  while (group->pending > 0) {
+    g_cond_wait(&group->cond, &group->lock);
+  }
+  g_mutex_unlock(&group->lock);
+}
+
+void
+pdf_pool_group_free(pdf_pool_group_t* group)
+{
+  if (group == NULL) {
+    return;
+  }
+
+  g_cond_clear(&group->cond);
+  g_mutex_clear(&group->lock);
+  g_free(group);
+}
@@ -0,0 +1,86 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "plugin.h"
+
+typedef struct pdf_pool_s pdf_pool_t;
+typedef struct pdf_pool_group_s pdf_pool_group_t;
+
+/**
+ * Function that is run by a worker of the pool
+ *
+ * @param poppler_document The worker's own poppler document or NULL if the
+ *   job is discarded because the pool is shut down or the worker could not
+ *   open the document
+ * @param data Job data
+ */
+typedef void (*pdf_pool_function_t)(PopplerDocument* poppler_document, void* data);
+
+/**
+ * Creates a pool of worker threads. Every worker opens its own poppler
+ * document for the file of the given document on first use, so pages can be
+ * processed in parallel without sharing poppler objects between threads.
+ *
+ * Workers of background pools run with the lowest priority (on Linux), so
+ * that they do not slow down rendering and the rest of the system.
+ *
+ * @param pdf_document The document
+ * @param n_workers Number of worker threads
+ * @param background Set to true to lower the priority of the workers
+ * @return The pool or NULL if an error occurred
+ */
+GIRARA_HIDDEN pdf_pool_t* pdf_pool_new(pdf_document_t* pdf_document,
+    unsigned int n_workers, bool background);
+
+/**
+ * Shuts the pool down. Running jobs are waited for, queued jobs are discarded.
+ *
+ * @param pool The pool
+ */
+GIRARA_HIDDEN void pdf_pool_free(pdf_pool_t* pool);
+
+/**
+ * Returns the number of workers of the pool
+ *
+ * @param pool The pool
+ * @return Number of workers
+ */
+GIRARA_HIDDEN unsigned int pdf_pool_get_size(pdf_pool_t* pool);
+
+/**
+ * Queues a job. Jobs are distributed over the workers' queues; an idle worker
+ * steals jobs from the other queues.
+ *
+ * @param pool The pool
+ * @param group Group the job belongs to or NULL
+ * @param function Job function
+ * @param data Job data
+ * @param urgent Set to true to run the job before all non-urgent jobs
+ */
+GIRARA_HIDDEN void pdf_pool_push(pdf_pool_t* pool, pdf_pool_group_t* group,
+    pdf_pool_function_t function, void* data, bool urgent);
+
+/**
+ * Creates a group of jobs that can be waited for
+ *
+ * @return The group
+ */
+GIRARA_HIDDEN pdf_pool_group_t* pdf_pool_group_new(void);
+
+/**
+ * Waits until all jobs of the group have finished or were discarded
+ *
+ * @param group The group
+ */
+GIRARA_HIDDEN void pdf_pool_group_wait(pdf_pool_group_t* group);
+
+/**
+ * Frees a group. All of its jobs need to be finished.
+ *
+ * @param group The group
+ */
+GIRARA_HIDDEN void pdf_pool_group_free(pdf_pool_group_t* group);
+
+#endif // POOL_H
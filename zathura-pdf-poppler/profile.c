@@ -0,0 +1,425 @@
+/* See LICENSE file for license and copyright information */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <girara/utils.h>
+
+#include "profile.h"
+
+/* Number of histogram buckets; bucket i counts calls shorter than 2^i µs */
+#define PROFILE_BUCKETS 32
+/* Maximal number of recorded trace events */
+#define PROFILE_MAX_EVENTS (1 << 20)
+
+typedef enum pdf_profile_function_e {
+  PROFILE_DOCUMENT_OPEN,
+  PROFILE_DOCUMENT_FREE,
+  PROFILE_DOCUMENT_INDEX_GENERATE,
+  PROFILE_DOCUMENT_SAVE_AS,
+  PROFILE_DOCUMENT_ATTACHMENTS_GET,
+  PROFILE_DOCUMENT_ATTACHMENT_SAVE,
+  PROFILE_DOCUMENT_GET_INFORMATION,
+  PROFILE_PAGE_INIT,
+  PROFILE_PAGE_CLEAR,
+  PROFILE_PAGE_SEARCH_TEXT,
+  PROFILE_PAGE_LINKS_GET,
+  PROFILE_PAGE_FORM_FIELDS_GET,
+  PROFILE_PAGE_IMAGES_GET,
+  PROFILE_PAGE_GET_TEXT,
+  PROFILE_PAGE_RENDER_CAIRO,
+  PROFILE_PAGE_IMAGE_GET_CAIRO,
+  PROFILE_PAGE_GET_LABEL,
+  PROFILE_N_FUNCTIONS
+} pdf_profile_function_t;
+
+static const char* profile_function_names[PROFILE_N_FUNCTIONS] = {
+  "document_open",
+  "document_free",
+  "document_index_generate",
+  "document_save_as",
+  "document_attachments_get",
+  "document_attachment_save",
+  "document_get_information",
+  "page_init",
+  "page_clear",
+  "page_search_text",
+  "page_links_get",
+  "page_form_fields_get",
+  "page_images_get",
+  "page_get_text",
+  "page_render_cairo",
+  "page_image_get_cairo",
+  "page_get_label"
+};
+
+typedef struct pdf_profile_counter_s {
+  guint64 calls; /**< Number of calls */
+  gint64 total; /**< Sum of the durations in µs */
+  gint64 max; /**< Longest duration in µs */
+  int max_page; /**< Page of the longest call or -1 */
+  guint64 histogram[PROFILE_BUCKETS]; /**< Calls per duration bucket */
+} pdf_profile_counter_t;
+
+typedef struct pdf_profile_event_s {
+  pdf_profile_function_t function; /**< Called function */
+  int page; /**< Page index or -1 */
+  unsigned int thread; /**< Sequential thread id */
+  gint64 start; /**< Start in µs since the first recorded call */
+  gint64 duration; /**< Duration in µs */
+} pdf_profile_event_t;
+
+static struct {
+  bool enabled; /**< Set if ZATHURA_PDF_POPPLER_PROFILE is set */
+  char* path; /**< Trace file */
+  gint64 epoch; /**< Monotonic time of the initialization */
+  pdf_profile_counter_t counters[PROFILE_N_FUNCTIONS]; /**< Counters per function */
+  GArray* events; /**< Recorded pdf_profile_event_t */
+  guint64 dropped; /**< Events not recorded since the limit was reached */
+  GMutex lock; /**< Protects the counters and events */
+} profile;
+
+static gsize profile_initialized = 0;
+static gint profile_next_thread  = 0;
+static GPrivate profile_thread   = G_PRIVATE_INIT(NULL);
+
+static bool
+profile_enabled(void)
+{
+  if (g_once_init_enter(&profile_initialized)) {
+    const char* path = g_getenv("ZATHURA_PDF_POPPLER_PROFILE");
+    if (path != NULL && *path != '\0') {
+      profile.path    = g_strdup(path);
+      profile.epoch   = g_get_monotonic_time();
+      profile.events  = g_array_new(FALSE, FALSE, sizeof(pdf_profile_event_t));
+      profile.enabled = true;
+      for (unsigned int i = 0; i < PROFILE_N_FUNCTIONS; i++) {
+        profile.counters[i].max_page = -1;
+      }
+    }
+    g_once_init_leave(&profile_initialized, 1);
+  }
+
+  return profile.enabled;
+}
+
+/* Returns the start time of a call or 0 if profiling is disabled */
+static gint64
+profile_begin(void)
+{
+  if (profile_enabled() == false) {
+    return 0;
+  }
+
+  return g_get_monotonic_time();
+}
+
+static unsigned int
+profile_thread_id(void)
+{
+  unsigned int id = GPOINTER_TO_UINT(g_private_get(&profile_thread));
+  if (id == 0) {
+    id = (unsigned int) g_atomic_int_add(&profile_next_thread, 1) + 1;
+    g_private_set(&profile_thread, GUINT_TO_POINTER(id));
+  }
+
+  return id;
+}
+
+static void
+profile_end(pdf_profile_function_t function, int page, gint64 start)
+{
+  if (start == 0) {
+    return;
+  }
+
+  const gint64 duration          = g_get_monotonic_time() - start;
+  const unsigned int thread      = profile_thread_id();
+  const unsigned int bucket      = MIN(g_bit_storage((gulong) duration), PROFILE_BUCKETS - 1);
+  pdf_profile_counter_t* counter = &profile.counters[function];
+
+  g_mutex_lock(&profile.lock);
+  counter->calls++;
+  counter->total += duration;
+  counter->histogram[bucket]++;
+  if (duration > counter->max || counter->calls == 1) {
+    counter->max      = duration;
+    counter->max_page = page;
+  }
+
+  if (profile.events->len < PROFILE_MAX_EVENTS) {
+    const pdf_profile_event_t event = {
+      .function = function,
+      .page     = page,
+      .thread   = thread,
+      .start    = start - profile.epoch,
+      .duration = duration
+    };
+    g_array_append_val(profile.events, event);
+  } else {
+    profile.dropped++;
+  }
+  g_mutex_unlock(&profile.lock);
+}
+
+static int
+profile_page_index(zathura_page_t* page)
+{
+  return page != NULL ? (int) zathura_page_get_index(page) : -1;
+}
+
+/* Upper bound of the bucket that contains the given percentile in µs */
+static guint64
+profile_percentile(const pdf_profile_counter_t* counter, unsigned int percentile)
+{
+  const guint64 rank = (counter->calls * percentile + 99) / 100;
+
+  guint64 count = 0;
+  for (unsigned int i = 0; i < PROFILE_BUCKETS; i++) {
+    count += counter->histogram[i];
+    if (count >= rank) {
+      return (guint64) 1 << i;
+    }
+  }
+
+  return (guint64) 1 << (PROFILE_BUCKETS - 1);
+}
+
+/* Logs the counters and writes the trace file; requires the lock */
+static void
+profile_write(void)
+{
+  for (unsigned int i = 0; i < PROFILE_N_FUNCTIONS; i++) {
+    const pdf_profile_counter_t* counter = &profile.counters[i];
+    if (counter->calls == 0) {
+      continue;
+    }
+
+    char page[32] = "";
+    if (counter->max_page >= 0) {
+      snprintf(page, sizeof(page), " on page %d", counter->max_page + 1);
+    }
+
+    girara_info("%s: %" G_GUINT64_FORMAT " calls, total %.1f ms, mean %" G_GINT64_FORMAT
+        " us, p50 < %" G_GUINT64_FORMAT " us, p90 < %" G_GUINT64_FORMAT " us, p99 < %"
+        G_GUINT64_FORMAT " us, max %" G_GINT64_FORMAT " us%s",
+        profile_function_names[i], counter->calls, counter->total / 1000.0,
+        counter->total / (gint64) counter->calls, profile_percentile(counter, 50),
+        profile_percentile(counter, 90), profile_percentile(counter, 99), counter->max,
+        page);
+  }
+
+  if (profile.dropped > 0) {
+    girara_info("%" G_GUINT64_FORMAT " calls were not added to the trace", profile.dropped);
+  }
+
+  GString* trace = g_string_sized_new(128 + (gsize) profile.events->len * 128);
+  const int pid  = (int) getpid();
+  g_string_append(trace, "{\"traceEvents\":[");
+  for (guint i = 0; i < profile.events->len; i++) {
+    const pdf_profile_event_t* event = &g_array_index(profile.events, pdf_profile_event_t, i);
+    g_string_append_printf(trace,
+        "%s\n{\"name\":\"%s\",\"cat\":\"zathura-pdf-poppler\",\"ph\":\"X\",\"ts\":%"
+        G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ",\"pid\":%d,\"tid\":%u",
+        i == 0 ? "" : ",", profile_function_names[event->function], event->start,
+        event->duration, pid, event->thread);
+    if (event->page >= 0) {
+      g_string_append_printf(trace, ",\"args\":{\"page\":%d}", event->page + 1);
+    }
+    g_string_append_c(trace, '}');
+  }
+  g_string_append(trace, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  GError* error = NULL;
+  if (g_file_set_contents(profile.path, trace->str, trace->len, &error) == FALSE) {
+    girara_warning("Could not write profile '%s': %s", profile.path, error->message);
+    g_error_free(error);
+  }
+  g_string_free(trace, TRUE);
+}
+
+zathura_error_t
+pdf_profile_document_open(zathura_document_t* document)
+{
+  const gint64 start           = profile_begin();
+  const zathura_error_t result = pdf_document_open(document);
+  profile_end(PROFILE_DOCUMENT_OPEN, -1, start);
+
+  return result;
+}
+
+zathura_error_t
+pdf_profile_document_free(zathura_document_t* document, void* data)
+{
+  const gint64 start           = profile_begin();
+  const zathura_error_t result = pdf_document_free(document, data);
+  profile_end(PROFILE_DOCUMENT_FREE, -1, start);
+
+  /* the plugin may be unloaded once the last document is closed, so the
+   * results up to now are written every time a document is closed */
+  if (start != 0) {
+    g_mutex_lock(&profile.lock);
+    profile_write();
+    g_mutex_unlock(&profile.lock);
+  }
+
+  return result;
+}
+
+girara_tree_node_t*
+pdf_profile_document_index_generate(zathura_document_t* document, void* data,
+    zathura_error_t* error)
+{
+  const gint64 start         = profile_begin();
+  girara_tree_node_t* result = pdf_document_index_generate(document, data, error);
+  profile_end(PROFILE_DOCUMENT_INDEX_GENERATE, -1, start);
+
+  return result;
+}
+
+zathura_error_t
+pdf_profile_document_save_as(zathura_document_t* document, void* data, const char* path)
+{
+  const gint64 start           = profile_begin();
+  const zathura_error_t result = pdf_document_save_as(document, data, path);
+  profile_end(PROFILE_DOCUMENT_SAVE_AS, -1, start);
+
+  return result;
+}
+
+girara_list_t*
+pdf_profile_document_attachments_get(zathura_document_t* document, void* data,
+    zathura_error_t* error)
+{
+  const gint64 start    = profile_begin();
+  girara_list_t* result = pdf_document_attachments_get(document, data, error);
+  profile_end(PROFILE_DOCUMENT_ATTACHMENTS_GET, -1, start);
+
+  return result;
+}
+
+zathura_error_t
+pdf_profile_document_attachment_save(zathura_document_t* document, void* data,
+    const char* attachment, const char* file)
+{
+  const gint64 start           = profile_begin();
+  const zathura_error_t result = pdf_document_attachment_save(document, data, attachment, file);
+  profile_end(PROFILE_DOCUMENT_ATTACHMENT_SAVE, -1, start);
+
+  return result;
+}
+
+girara_list_t*
+pdf_profile_document_get_information(zathura_document_t* document, void* data,
+    zathura_error_t* error)
+{
+  const gint64 start    = profile_begin();
+  girara_list_t* result = pdf_document_get_information(document, data, error);
+  profile_end(PROFILE_DOCUMENT_GET_INFORMATION, -1, start);
+
+  return result;
+}
+
+zathura_error_t
+pdf_profile_page_init(zathura_page_t* page)
+{
+  const gint64 start           = profile_begin();
+  const zathura_error_t result = pdf_page_init(page);
+  profile_end(PROFILE_PAGE_INIT, profile_page_index(page), start);
+
+  return result;
+}
+
+zathura_error_t
+pdf_profile_page_clear(zathura_page_t* page, void* data)
+{
+  const gint64 start           = profile_begin();
+  const zathura_error_t result = pdf_page_clear(page, data);
+  profile_end(PROFILE_PAGE_CLEAR, profile_page_index(page), start);
+
+  return result;
+}
+
+girara_list_t*
+pdf_profile_page_search_text(zathura_page_t* page, void* data, const char* text,
+    zathura_error_t* error)
+{
+  const gint64 start    = profile_begin();
+  girara_list_t* result = pdf_page_search_text(page, data, text, error);
+  profile_end(PROFILE_PAGE_SEARCH_TEXT, profile_page_index(page), start);
+
+  return result;
+}
+
+girara_list_t*
+pdf_profile_page_links_get(zathura_page_t* page, void* data, zathura_error_t* error)
+{
+  const gint64 start    = profile_begin();
+  girara_list_t* result = pdf_page_links_get(page, data, error);
+  profile_end(PROFILE_PAGE_LINKS_GET, profile_page_index(page), start);
+
+  return result;
+}
+
+girara_list_t*
+pdf_profile_page_form_fields_get(zathura_page_t* page, void* data, zathura_error_t* error)
+{
+  const gint64 start    = profile_begin();
+  girara_list_t* result = pdf_page_form_fields_get(page, data, error);
+  profile_end(PROFILE_PAGE_FORM_FIELDS_GET, profile_page_index(page), start);
+
+  return result;
+}
+
+girara_list_t*
+pdf_profile_page_images_get(zathura_page_t* page, void* data, zathura_error_t* error)
+{
+  const gint64 start    = profile_begin();
+  girara_list_t* result = pdf_page_images_get(page, data, error);
+  profile_end(PROFILE_PAGE_IMAGES_GET, profile_page_index(page), start);
+
+  return result;
+}
+
+char*
+pdf_profile_page_get_text(zathura_page_t* page, void* data, zathura_rectangle_t rectangle,
+    zathura_error_t* error)
+{
+  const gint64 start = profile_begin();
+  char* result       = pdf_page_get_text(page, data, rectangle, error);
+  profile_end(PROFILE_PAGE_GET_TEXT, profile_page_index(page), start);
+
+  return result;
+}
+
+zathura_error_t
+pdf_profile_page_render_cairo(zathura_page_t* page, void* data, cairo_t* cairo,
+    bool printing)
+{
+  const gint64 start           = profile_begin();
+  const zathura_error_t result = pdf_page_render_cairo(page, data, cairo, printing);
+  profile_end(PROFILE_PAGE_RENDER_CAIRO, profile_page_index(page), start);
+
+  return result;
+}
+
+cairo_surface_t*
+pdf_profile_page_image_get_cairo(zathura_page_t* page, void* data, zathura_image_t* image,
+    zathura_error_t* error)
+{
+  const gint64 start      = profile_begin();
+  cairo_surface_t* result = pdf_page_image_get_cairo(page, data, image, error);
+  profile_end(PROFILE_PAGE_IMAGE_GET_CAIRO, profile_page_index(page), start);
+
+  return result;
+}
+
+zathura_error_t
+pdf_profile_page_get_label(zathura_page_t* page, void* data, char** label)
+{
+  const gint64 start           = profile_begin();
+  const zathura_error_t result = pdf_page_get_label(page, data, label);
+  profile_end(PROFILE_PAGE_GET_LABEL, profile_page_index(page), start);
+
+  return result;
+}
@@ -0,0 +1,65 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "plugin.h"
+
+/*
+ * Instrumented versions of the plugin functions. They are registered with
+ * zathura instead of the plain functions and record the call count, a latency
+ * histogram and the page index of every call if ZATHURA_PDF_POPPLER_PROFILE
+ * names an output file. A summary is logged and a trace in the Chrome trace
+ * event format is written to the file whenever a document is closed. Without
+ * the variable, they only check a flag before calling the plain functions.
+ */
+
+GIRARA_HIDDEN zathura_error_t pdf_profile_document_open(zathura_document_t* document);
+
+GIRARA_HIDDEN zathura_error_t pdf_profile_document_free(zathura_document_t* document,
+    void* data);
+
+GIRARA_HIDDEN girara_tree_node_t* pdf_profile_document_index_generate(zathura_document_t*
+    document, void* data, zathura_error_t* error);
+
+GIRARA_HIDDEN zathura_error_t pdf_profile_document_save_as(zathura_document_t* document,
+    void* data, const char* path);
+
+GIRARA_HIDDEN girara_list_t* pdf_profile_document_attachments_get(zathura_document_t*
+    document, void* data, zathura_error_t* error);
+
+GIRARA_HIDDEN zathura_error_t pdf_profile_document_attachment_save(zathura_document_t*
+    document, void* data, const char* attachment, const char* file);
+
+GIRARA_HIDDEN girara_list_t* pdf_profile_document_get_information(zathura_document_t*
+    document, void* data, zathura_error_t* error);
+
+GIRARA_HIDDEN zathura_error_t pdf_profile_page_init(zathura_page_t* page);
+
+GIRARA_HIDDEN zathura_error_t pdf_profile_page_clear(zathura_page_t* page, void* data);
+
+GIRARA_HIDDEN girara_list_t* pdf_profile_page_search_text(zathura_page_t* page,
+    void* data, const char* text, zathura_error_t* error);
+
+GIRARA_HIDDEN girara_list_t* pdf_profile_page_links_get(zathura_page_t* page,
+    void* data, zathura_error_t* error);
+
+GIRARA_HIDDEN girara_list_t* pdf_profile_page_form_fields_get(zathura_page_t* page,
+    void* data, zathura_error_t* error);
+
+GIRARA_HIDDEN girara_list_t* pdf_profile_page_images_get(zathura_page_t* page,
+    void* data, zathura_error_t* error);
+
+GIRARA_HIDDEN char* pdf_profile_page_get_text(zathura_page_t* page, void* data,
+    zathura_rectangle_t rectangle, zathura_error_t* error);
+
+GIRARA_HIDDEN zathura_error_t pdf_profile_page_render_cairo(zathura_page_t* page,
+    void* data, cairo_t* cairo, bool printing);
+
+GIRARA_HIDDEN cairo_surface_t* pdf_profile_page_image_get_cairo(zathura_page_t* page,
+    void* data, zathura_image_t* image, zathura_error_t* error);
+
+GIRARA_HIDDEN zathura_error_t pdf_profile_page_get_label(zathura_page_t* page,
+    void* data, char** label);
+
+#endif // PROFILE_H
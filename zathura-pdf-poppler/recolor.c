@@ -0,0 +1,300 @@
+/* See LICENSE file for license and copyright information */
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <girara/utils.h>
+
+#include "recolor.h"
+
+/* Luminance weights of red, green and blue (sum 256) */
+#define RECOLOR_WEIGHT_RED 77
+#define RECOLOR_WEIGHT_GREEN 150
+#define RECOLOR_WEIGHT_BLUE 29
+
+struct pdf_recolor_s {
+  guint32 dark[3]; /**< Color black is mapped to (blue, green, red) */
+  guint32 light[3]; /**< Color white is mapped to (blue, green, red) */
+};
+
+static bool
+recolor_parse_color(const char* value, guint32 color[3])
+{
+  if (value[0] != '#' || strlen(value) != 7) {
+    return false;
+  }
+
+  /* stored in the byte order of cairo's pixels */
+  for (unsigned int i = 0; i < 3; i++) {
+    const int high = g_ascii_xdigit_value(value[1 + 2 * i]);
+    const int low  = g_ascii_xdigit_value(value[2 + 2 * i]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    color[2 - i] = high * 16 + low;
+  }
+
+  return true;
+}
+
+pdf_recolor_t*
+pdf_recolor_new(const char* colors)
+{
+  if (colors == NULL || *colors == '\0') {
+    return NULL;
+  }
+
+  pdf_recolor_t* recolor = g_malloc0(sizeof(pdf_recolor_t));
+  char** parts           = g_strsplit(colors, ",", -1);
+
+  const bool valid = g_strv_length(parts) == 2 &&
+    recolor_parse_color(g_strstrip(parts[0]), recolor->dark) == true &&
+    recolor_parse_color(g_strstrip(parts[1]), recolor->light) == true;
+  g_strfreev(parts);
+
+  if (valid == false) {
+    girara_warning("Invalid recolor colors '%s'", colors);
+    g_free(recolor);
+    return NULL;
+  }
+
+  return recolor;
+}
+
+void
+pdf_recolor_free(pdf_recolor_t* recolor)
+{
+  g_free(recolor);
+}
+
+/* Maps n premultiplied pixels. Every channel becomes
+ *   (dark * (alpha - luminance) + light * luminance) / 255
+ * which is the unpremultiplied mapping multiplied by alpha again. The alpha
+ * bits are set before the mapping for surfaces without alpha channel. The
+ * vectorized loops below compute exactly the same values. */
+static void
+recolor_row_scalar(const pdf_recolor_t* recolor, guint32* pixels, unsigned int n, guint32 alpha)
+{
+  for (unsigned int i = 0; i < n; i++) {
+    const guint32 pixel = pixels[i] | alpha;
+    const guint32 a     = pixel >> 24;
+
+    guint32 y = (RECOLOR_WEIGHT_RED * ((pixel >> 16) & 0xFF) +
+        RECOLOR_WEIGHT_GREEN * ((pixel >> 8) & 0xFF) + RECOLOR_WEIGHT_BLUE * (pixel & 0xFF) +
+        128) >> 8;
+    y = MIN(y, a);
+
+    guint32 result = a << 24;
+    for (unsigned int c = 0; c < 3; c++) {
+      const guint32 x = recolor->dark[c] * (a - y) + recolor->light[c] * y + 128;
+      result |= ((x + (x >> 8)) >> 8) << (8 * c);
+    }
+    pixels[i] = result;
+  }
+}
+
+static void
+recolor_row(const pdf_recolor_t* recolor, guint32* pixels, unsigned int n, guint32 alpha)
+{
+  unsigned int i = 0;
+
+#if defined(__AVX2__)
+  /* all values stay below 2^16, so 16 bit multiplications are exact */
+  const __m256i mask     = _mm256_set1_epi32(0xFF);
+  const __m256i round    = _mm256_set1_epi32(128);
+  const __m256i set      = _mm256_set1_epi32(alpha);
+  const __m256i w_red    = _mm256_set1_epi32(RECOLOR_WEIGHT_RED);
+  const __m256i w_green  = _mm256_set1_epi32(RECOLOR_WEIGHT_GREEN);
+  const __m256i w_blue   = _mm256_set1_epi32(RECOLOR_WEIGHT_BLUE);
+  __m256i dark[3];
+  __m256i light[3];
+  for (unsigned int c = 0; c < 3; c++) {
+    dark[c]  = _mm256_set1_epi32(recolor->dark[c]);
+    light[c] = _mm256_set1_epi32(recolor->light[c]);
+  }
+
+  for (; i + 8 <= n; i += 8) {
+    const __m256i pixel = _mm256_or_si256(_mm256_loadu_si256((const __m256i*) (pixels + i)), set);
+    const __m256i a     = _mm256_srli_epi32(pixel, 24);
+
+    __m256i channels[3];
+    for (unsigned int c = 0; c < 3; c++) {
+      channels[c] = _mm256_and_si256(_mm256_srli_epi32(pixel, 8 * c), mask);
+    }
+
+    __m256i y = _mm256_add_epi32(_mm256_mullo_epi16(channels[2], w_red),
+        _mm256_mullo_epi16(channels[1], w_green));
+    y = _mm256_add_epi32(y, _mm256_add_epi32(_mm256_mullo_epi16(channels[0], w_blue), round));
+    y = _mm256_min_epi16(_mm256_srli_epi32(y, 8), a);
+    const __m256i inverse = _mm256_sub_epi32(a, y);
+
+    __m256i result = _mm256_slli_epi32(a, 24);
+    for (unsigned int c = 0; c < 3; c++) {
+      __m256i x = _mm256_add_epi32(_mm256_mullo_epi16(dark[c], inverse),
+          _mm256_mullo_epi16(light[c], y));
+      x = _mm256_add_epi32(x, round);
+      x = _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(x, 8)), 8);
+      result = _mm256_or_si256(result, _mm256_slli_epi32(x, 8 * c));
+    }
+
+    _mm256_storeu_si256((__m256i*) (pixels + i), result);
+  }
+#elif defined(__SSE2__)
+  /* all values stay below 2^16, so 16 bit multiplications are exact */
+  const __m128i mask    = _mm_set1_epi32(0xFF);
+  const __m128i round   = _mm_set1_epi32(128);
+  const __m128i set     = _mm_set1_epi32(alpha);
+  const __m128i w_red   = _mm_set1_epi32(RECOLOR_WEIGHT_RED);
+  const __m128i w_green = _mm_set1_epi32(RECOLOR_WEIGHT_GREEN);
+  const __m128i w_blue  = _mm_set1_epi32(RECOLOR_WEIGHT_BLUE);
+  __m128i dark[3];
+  __m128i light[3];
+  for (unsigned int c = 0; c < 3; c++) {
+    dark[c]  = _mm_set1_epi32(recolor->dark[c]);
+    light[c] = _mm_set1_epi32(recolor->light[c]);
+  }
+
+  for (; i + 4 <= n; i += 4) {
+    const __m128i pixel = _mm_or_si128(_mm_loadu_si128((const __m128i*) (pixels + i)), set);
+    const __m128i a     = _mm_srli_epi32(pixel, 24);
+
+    __m128i channels[3];
+    for (unsigned int c = 0; c < 3; c++) {
+      channels[c] = _mm_and_si128(_mm_srli_epi32(pixel, 8 * c), mask);
+    }
+
+    __m128i y = _mm_add_epi32(_mm_mullo_epi16(channels[2], w_red),
+        _mm_mullo_epi16(channels[1], w_green));
+    y = _mm_add_epi32(y, _mm_add_epi32(_mm_mullo_epi16(channels[0], w_blue), round));
+    y = _mm_min_epi16(_mm_srli_epi32(y, 8), a);
+    const __m128i inverse = _mm_sub_epi32(a, y);
+
+    __m128i result = _mm_slli_epi32(a, 24);
+    for (unsigned int c = 0; c < 3; c++) {
+      __m128i x = _mm_add_epi32(_mm_mullo_epi16(dark[c], inverse),
+          _mm_mullo_epi16(light[c], y));
+      x = _mm_add_epi32(x, round);
+      x = _mm_srli_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 8)), 8);
+      result = _mm_or_si128(result, _mm_slli_epi32(x, 8 * c));
+    }
+
+    _mm_storeu_si128((__m128i*) (pixels + i), result);
+  }
+#elif defined(__ARM_NEON)
+  const uint32x4_t mask    = vdupq_n_u32(0xFF);
+  const uint32x4_t round   = vdupq_n_u32(128);
+  const uint32x4_t set     = vdupq_n_u32(alpha);
+  const uint32x4_t w_red   = vdupq_n_u32(RECOLOR_WEIGHT_RED);
+  const uint32x4_t w_green = vdupq_n_u32(RECOLOR_WEIGHT_GREEN);
+  const uint32x4_t w_blue  = vdupq_n_u32(RECOLOR_WEIGHT_BLUE);
+  const uint32x4_t dark_b  = vdupq_n_u32(recolor->dark[0]);
+  const uint32x4_t dark_g  = vdupq_n_u32(recolor->dark[1]);
+  const uint32x4_t dark_r  = vdupq_n_u32(recolor->dark[2]);
+  const uint32x4_t light_b = vdupq_n_u32(recolor->light[0]);
+  const uint32x4_t light_g = vdupq_n_u32(recolor->light[1]);
+  const uint32x4_t light_r = vdupq_n_u32(recolor->light[2]);
+
+  for (; i + 4 <= n; i += 4) {
+    const uint32x4_t pixel = vorrq_u32(vld1q_u32(pixels + i), set);
+    const uint32x4_t a     = vshrq_n_u32(pixel, 24);
+    const uint32x4_t b     = vandq_u32(pixel, mask);
+    const uint32x4_t g     = vandq_u32(vshrq_n_u32(pixel, 8), mask);
+    const uint32x4_t r     = vandq_u32(vshrq_n_u32(pixel, 16), mask);
+
+    uint32x4_t y = vmlaq_u32(vmlaq_u32(vmlaq_u32(round, r, w_red), g, w_green), b, w_blue);
+    y = vminq_u32(vshrq_n_u32(y, 8), a);
+    const uint32x4_t inverse = vsubq_u32(a, y);
+
+    uint32x4_t x_b = vaddq_u32(vmlaq_u32(vmulq_u32(dark_b, inverse), light_b, y), round);
+    uint32x4_t x_g = vaddq_u32(vmlaq_u32(vmulq_u32(dark_g, inverse), light_g, y), round);
+    uint32x4_t x_r = vaddq_u32(vmlaq_u32(vmulq_u32(dark_r, inverse), light_r, y), round);
+    x_b = vshrq_n_u32(vaddq_u32(x_b, vshrq_n_u32(x_b, 8)), 8);
+    x_g = vshrq_n_u32(vaddq_u32(x_g, vshrq_n_u32(x_g, 8)), 8);
+    x_r = vshrq_n_u32(vaddq_u32(x_r, vshrq_n_u32(x_r, 8)), 8);
+
+    const uint32x4_t result = vorrq_u32(vorrq_u32(vshlq_n_u32(a, 24), vshlq_n_u32(x_r, 16)),
+        vorrq_u32(vshlq_n_u32(x_g, 8), x_b));
+    vst1q_u32(pixels + i, result);
+  }
+#endif
+
+  recolor_row_scalar(recolor, pixels + i, n - i, alpha);
+}
+
+static bool
+recolor_row_in_area(const cairo_rectangle_int_t* area, int y)
+{
+  return area->y <= y && y < area->y + area->height;
+}
+
+void
+pdf_recolor_surface(const pdf_recolor_t* recolor, cairo_surface_t* surface,
+    cairo_rectangle_int_t area, const cairo_rectangle_int_t* keep, unsigned int n_keep)
+{
+  if (recolor == NULL || surface == NULL ||
+      cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE) {
+    return;
+  }
+
+  const cairo_format_t format = cairo_image_surface_get_format(surface);
+  if (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24) {
+    return;
+  }
+
+  const int left   = MAX(area.x, 0);
+  const int top    = MAX(area.y, 0);
+  const int right  = MIN(area.x + area.width, cairo_image_surface_get_width(surface));
+  const int bottom = MIN(area.y + area.height, cairo_image_surface_get_height(surface));
+  if (left >= right || top >= bottom) {
+    return;
+  }
+
+  const guint32 alpha = format == CAIRO_FORMAT_RGB24 ? 0xFF000000 : 0;
+  const int stride    = cairo_image_surface_get_stride(surface);
+
+  cairo_surface_flush(surface);
+  unsigned char* data = cairo_image_surface_get_data(surface);
+
+  for (int y = top; y < bottom; y++) {
+    guint32* row = (guint32*) (data + (size_t) y * stride);
+
+    /* recolor the parts of the row between the kept areas */
+    int x = left;
+    while (x < right) {
+      bool skipped = true;
+      while (skipped == true) {
+        skipped = false;
+        for (unsigned int i = 0; i < n_keep; i++) {
+          if (recolor_row_in_area(&keep[i], y) == true && keep[i].x <= x &&
+              x < keep[i].x + keep[i].width) {
+            x       = keep[i].x + keep[i].width;
+            skipped = true;
+          }
+        }
+      }
+
+      if (x >= right) {
+        break;
+      }
+
+      int next = right;
+      for (unsigned int i = 0; i < n_keep; i++) {
+        if (recolor_row_in_area(&keep[i], y) == true && keep[i].x > x) {
+          next = MIN(next, keep[i].x);
+        }
+      }
+
+      recolor_row(recolor, row + x, next - x, alpha);
+      x = next;
+    }
+  }
+
+  cairo_surface_mark_dirty_rectangle(surface, left, top, right - left, bottom - top);
+}
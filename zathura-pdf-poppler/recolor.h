@@ -0,0 +1,40 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef RECOLOR_H
+#define RECOLOR_H
+
+#include "plugin.h"
+
+typedef struct pdf_recolor_s pdf_recolor_t;
+
+/**
+ * Creates a color mapping like zathura's recolor mode: black is mapped to
+ * the dark color, white to the light color and everything in between to a
+ * mix of both according to its luminance.
+ *
+ * @param colors The dark and the light color as "#rrggbb,#rrggbb"
+ * @return The color mapping or NULL if colors is NULL, empty or invalid
+ */
+GIRARA_HIDDEN pdf_recolor_t* pdf_recolor_new(const char* colors);
+
+/**
+ * Frees the color mapping
+ *
+ * @param recolor The color mapping
+ */
+GIRARA_HIDDEN void pdf_recolor_free(pdf_recolor_t* recolor);
+
+/**
+ * Applies the color mapping to an area of a 32 bit image surface
+ *
+ * @param recolor The color mapping
+ * @param surface The image surface
+ * @param area Area of the surface to recolor
+ * @param keep Areas of the surface that are left unchanged
+ * @param n_keep Number of areas in keep
+ */
+GIRARA_HIDDEN void pdf_recolor_surface(const pdf_recolor_t* recolor,
+    cairo_surface_t* surface, cairo_rectangle_int_t area,
+    const cairo_rectangle_int_t* keep, unsigned int n_keep);
+
+#endif // RECOLOR_H
@@ -1,6 +1,414 @@
 /* See LICENSE file for license and copyright information */
 
+#include <math.h>
+#include <string.h>
+
 #include "plugin.h"
+#include "cache.h"
+#include "displaylist.h"
+#include "image.h"
+#include "pool.h"
+#include "recolor.h"
+
+static void
+render_region(PopplerPage* poppler_page, cairo_t* cairo,
+    zathura_rectangle_t region)
+{
+  cairo_save(cairo);
+
+  /* cairo drops everything outside of the clip before rasterizing it */
+  cairo_rectangle(cairo, region.x1, region.y1, region.x2 - region.x1,
+      region.y2 - region.y1);
+  cairo_clip(cairo);
+
+  poppler_page_render(poppler_page, cairo);
+
+  cairo_restore(cairo);
+}
+
+/* Number of pages before and after a rendered page that are prerendered */
+#define PRERENDER_PAGES 1
+
+typedef struct render_prerender_s {
+  pdf_document_t* pdf_document; /**< The document */
+  pdf_render_cache_key_t key; /**< Key of the rendered page */
+  double width; /**< Width of the page the key was computed for */
+  double height; /**< Height of the page the key was computed for */
+} render_prerender_t;
+
+/* Computes the area of an image surface of the given size that is covered by
+ * the region of the page transformed by the matrix. */
+static void
+render_transform_region(const cairo_matrix_t* matrix, zathura_rectangle_t region,
+    int width, int height, cairo_rectangle_int_t* area)
+{
+  const double corners[4][2] = {
+    { region.x1, region.y1 }, { region.x2, region.y1 },
+    { region.x1, region.y2 }, { region.x2, region.y2 }
+  };
+
+  double min_x = INFINITY;
+  double min_y = INFINITY;
+  double max_x = -INFINITY;
+  double max_y = -INFINITY;
+  for (unsigned int i = 0; i < 4; i++) {
+    double x = corners[i][0];
+    double y = corners[i][1];
+    cairo_matrix_transform_point(matrix, &x, &y);
+    min_x = MIN(min_x, x);
+    min_y = MIN(min_y, y);
+    max_x = MAX(max_x, x);
+    max_y = MAX(max_y, y);
+  }
+
+  const int left   = MAX(floor(min_x), 0);
+  const int top    = MAX(floor(min_y), 0);
+  const int right  = MIN(ceil(max_x), width);
+  const int bottom = MIN(ceil(max_y), height);
+
+  area->x      = left;
+  area->y      = top;
+  area->width  = MAX(right - left, 0);
+  area->height = MAX(bottom - top, 0);
+}
+
+/* Computes the area of the target image surface that is covered by the given
+ * region of the page. Returns false if the target is no image surface. */
+static bool
+render_get_target_area(cairo_t* cairo, zathura_rectangle_t region,
+    cairo_rectangle_int_t* area)
+{
+  cairo_surface_t* target = cairo_get_target(cairo);
+  if (cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE) {
+    return false;
+  }
+
+  double offset_x;
+  double offset_y;
+  cairo_surface_get_device_offset(target, &offset_x, &offset_y);
+  if (offset_x != 0 || offset_y != 0) {
+    return false;
+  }
+
+  cairo_matrix_t matrix;
+  cairo_get_matrix(cairo, &matrix);
+
+  render_transform_region(&matrix, region, cairo_image_surface_get_width(target),
+      cairo_image_surface_get_height(target), area);
+
+  return true;
+}
+
+/* Computes the areas of the target image surface that are covered by images
+ * of the page. Images keep their colors when the page is recolored. */
+static GArray*
+render_get_image_areas(pdf_page_t* pdf_page, cairo_t* cairo)
+{
+  cairo_surface_t* target = cairo_get_target(cairo);
+  GArray* areas           = g_array_new(FALSE, FALSE, sizeof(cairo_rectangle_int_t));
+  GArray* regions         = g_array_new(FALSE, FALSE, sizeof(zathura_rectangle_t));
+  pdf_page_images_get_areas(pdf_page, regions);
+
+  cairo_matrix_t matrix;
+  cairo_get_matrix(cairo, &matrix);
+
+  for (guint i = 0; i < regions->len; i++) {
+    cairo_rectangle_int_t area;
+    render_transform_region(&matrix, g_array_index(regions, zathura_rectangle_t, i),
+        cairo_image_surface_get_width(target), cairo_image_surface_get_height(target),
+        &area);
+    if (area.width > 0 && area.height > 0) {
+      g_array_append_val(areas, area);
+    }
+  }
+
+  g_array_free(regions, TRUE);
+
+  return areas;
+}
+
+/* Applies the document's color mapping to the area of the target that is
+ * covered by the region of the page, except for images. */
+static void
+render_recolor(pdf_page_t* pdf_page, cairo_t* cairo, zathura_rectangle_t region)
+{
+  const pdf_recolor_t* recolor = pdf_page->document->recolor;
+
+  cairo_rectangle_int_t area;
+  if (recolor == NULL || render_get_target_area(cairo, region, &area) == false) {
+    return;
+  }
+
+  GArray* keep = render_get_image_areas(pdf_page, cairo);
+  pdf_recolor_surface(recolor, cairo_get_target(cairo), area,
+      (const cairo_rectangle_int_t*) keep->data, keep->len);
+  g_array_free(keep, TRUE);
+}
+
+/* Replays the display list of the page onto the region of the target.
+ * Returns false if the page has no display list. */
+static bool
+render_display_list(pdf_page_t* pdf_page, cairo_t* cairo, zathura_rectangle_t region)
+{
+  cairo_surface_t* list = pdf_display_lists_get(pdf_page->document->display_lists, pdf_page);
+  if (list == NULL) {
+    return false;
+  }
+
+  cairo_save(cairo);
+  cairo_rectangle(cairo, region.x1, region.y1, region.x2 - region.x1,
+      region.y2 - region.y1);
+  cairo_clip(cairo);
+  cairo_set_source_surface(cairo, list, 0, 0);
+  cairo_paint(cairo);
+  cairo_restore(cairo);
+
+  cairo_surface_destroy(list);
+
+  return true;
+}
+
+/* Renders the region of the page onto the target, by replaying its display
+ * list if possible, and applies the document's color mapping if requested. */
+static zathura_error_t
+render_page(pdf_page_t* pdf_page, cairo_t* cairo, zathura_rectangle_t region,
+    bool recolor)
+{
+  if (pdf_page->document->display_lists == NULL ||
+      render_display_list(pdf_page, cairo, region) == false) {
+    PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+    if (poppler_page == NULL) {
+      return ZATHURA_ERROR_UNKNOWN;
+    }
+
+    render_region(poppler_page, cairo, region);
+    g_object_unref(poppler_page);
+  }
+
+  if (recolor == true) {
+    render_recolor(pdf_page, cairo, region);
+  }
+
+  return ZATHURA_ERROR_OK;
+}
+
+/* Creates the surface of a cache entry and a cairo object that maps page
+ * coordinates onto it. The surface is filled with white like the targets
+ * zathura renders onto, so that blend modes and knockout groups see the same
+ * background as when rendering directly. Returns NULL if the surface cannot
+ * be allocated. */
+static cairo_t*
+render_layer_new(const pdf_render_cache_key_t* key)
+{
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+      key->area.width, key->area.height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+
+  cairo_matrix_t matrix = key->matrix;
+  matrix.x0 -= key->area.x;
+  matrix.y0 -= key->area.y;
+
+  cairo_t* layer = cairo_create(surface);
+  cairo_surface_destroy(surface);
+
+  cairo_set_source_rgb(layer, 1, 1, 1);
+  cairo_paint(layer);
+
+  cairo_set_matrix(layer, &matrix);
+
+  return layer;
+}
+
+static void
+render_prerender(PopplerDocument* poppler_document, void* data)
+{
+  render_prerender_t* job      = data;
+  pdf_document_t* pdf_document = job->pdf_document;
+
+  PopplerPage* poppler_page = NULL;
+  if (poppler_document != NULL) {
+    poppler_page = poppler_document_get_page(poppler_document, job->key.page);
+  }
+
+  if (poppler_page != NULL) {
+    double width;
+    double height;
+    poppler_page_get_size(poppler_page, &width, &height);
+
+    /* zathura only asks for the same area with the same transformation if
+     * the page has the same size */
+    cairo_t* layer = NULL;
+    if (width == job->width && height == job->height &&
+        (layer = render_layer_new(&job->key)) != NULL) {
+      const zathura_rectangle_t region = { 0, 0, width, height };
+      render_region(poppler_page, layer, region);
+      if (cairo_status(layer) == CAIRO_STATUS_SUCCESS) {
+        pdf_render_cache_insert(pdf_document->render_cache, &job->key,
+            cairo_get_target(layer));
+      }
+      cairo_destroy(layer);
+    }
+
+    g_object_unref(poppler_page);
+  }
+
+  g_mutex_lock(&pdf_document->lock);
+  g_hash_table_remove(pdf_document->prerendering, GUINT_TO_POINTER(job->key.page));
+  g_mutex_unlock(&pdf_document->lock);
+
+  g_free(job);
+}
+
+/* Queues the rendering of a page into the render cache with the key of
+ * another page, unless it is cached or queued already. */
+static void
+render_prerender_page(pdf_document_t* pdf_document, const pdf_render_cache_key_t* key,
+    zathura_rectangle_t region, int index)
+{
+  if (index < 0 || (unsigned int) index >= pdf_document->number_of_pages) {
+    return;
+  }
+
+  pdf_render_cache_key_t page_key = *key;
+  page_key.page                   = index;
+  if (pdf_render_cache_contains(pdf_document->render_cache, &page_key) == true) {
+    return;
+  }
+
+  g_mutex_lock(&pdf_document->lock);
+  const bool queued = g_hash_table_contains(pdf_document->prerendering,
+      GUINT_TO_POINTER(page_key.page));
+  if (queued == false) {
+    g_hash_table_add(pdf_document->prerendering, GUINT_TO_POINTER(page_key.page));
+  }
+  g_mutex_unlock(&pdf_document->lock);
+
+  if (queued == true) {
+    return;
+  }
+
+  render_prerender_t* job = g_malloc0(sizeof(render_prerender_t));
+  job->pdf_document       = pdf_document;
+  job->key                = page_key;
+  job->width              = region.x2;
+  job->height             = region.y2;
+
+  pdf_pool_push(pdf_document->pool, NULL, render_prerender, job, false);
+}
+
+/* Renders the region of the page through the document's render cache. The
+ * page is rendered onto a white surface that is kept in the cache and painted
+ * onto the target. If prerender is set, the region covers the whole
+ * page and the neighbouring pages are rendered into the cache by the
+ * document's pool. Returns false if the target or its transformation cannot
+ * be cached. */
+static bool
+render_cached(pdf_page_t* pdf_page, cairo_t* cairo, zathura_rectangle_t region,
+    bool prerender, zathura_error_t* error)
+{
+  pdf_render_cache_key_t key;
+  memset(&key, 0, sizeof(key));
+
+  /* keys are compared with ==, so a key with NaN would never be found */
+  cairo_get_matrix(cairo, &key.matrix);
+  if (isfinite(key.matrix.xx) == 0 || isfinite(key.matrix.yx) == 0 ||
+      isfinite(key.matrix.xy) == 0 || isfinite(key.matrix.yy) == 0 ||
+      isfinite(key.matrix.x0) == 0 || isfinite(key.matrix.y0) == 0) {
+    return false;
+  }
+
+  if (render_get_target_area(cairo, region, &key.area) == false) {
+    return false;
+  }
+
+  if (key.area.width == 0 || key.area.height == 0) {
+    *error = ZATHURA_ERROR_OK;
+    return true;
+  }
+
+  key.page = pdf_page->index;
+
+  pdf_render_cache_t* cache = pdf_page->document->render_cache;
+  cairo_surface_t* surface  = pdf_render_cache_lookup(cache, &key);
+
+  if (surface == NULL) {
+    cairo_t* layer = render_layer_new(&key);
+    if (layer == NULL) {
+      return false;
+    }
+
+    /* the cached surface keeps the original colors */
+    surface = cairo_surface_reference(cairo_get_target(layer));
+    *error  = render_page(pdf_page, layer, region, false);
+    cairo_destroy(layer);
+
+    if (*error != ZATHURA_ERROR_OK) {
+      cairo_surface_destroy(surface);
+      return true;
+    }
+
+    pdf_render_cache_insert(cache, &key, surface);
+  }
+
+  cairo_save(cairo);
+  cairo_identity_matrix(cairo);
+  cairo_set_source_surface(cairo, surface, key.area.x, key.area.y);
+  cairo_rectangle(cairo, key.area.x, key.area.y, key.area.width, key.area.height);
+  cairo_fill(cairo);
+  cairo_restore(cairo);
+
+  cairo_surface_destroy(surface);
+
+  if (prerender == true) {
+    for (int i = 1; i <= PRERENDER_PAGES; i++) {
+      render_prerender_page(pdf_page->document, &key, region, (int) pdf_page->index + i);
+      render_prerender_page(pdf_page->document, &key, region, (int) pdf_page->index - i);
+    }
+  }
+
+  *error = ZATHURA_ERROR_OK;
+  return true;
+}
+
+/* Computes the part of the page that is visible on the target. Returns false
+ * if nothing is visible. */
+static bool
+render_get_visible_region(cairo_t* cairo, double width, double height,
+    zathura_rectangle_t* region)
+{
+  double x1, y1, x2, y2;
+  cairo_clip_extents(cairo, &x1, &y1, &x2, &y2);
+
+  region->x1 = MAX(x1, 0);
+  region->y1 = MAX(y1, 0);
+  region->x2 = MIN(x2, width);
+  region->y2 = MIN(y2, height);
+
+  return region->x1 < region->x2 && region->y1 < region->y2;
+}
+
+/* Renders the region of the page at full quality, through the render cache
+ * if it is enabled, and applies the document's color mapping. If prerender is
+ * set, the region covers the whole page and its neighbours may be rendered
+ * into the cache in the background. */
+static zathura_error_t
+render_full(pdf_page_t* pdf_page, cairo_t* cairo, zathura_rectangle_t region,
+    bool prerender)
+{
+  zathura_error_t error = ZATHURA_ERROR_OK;
+  if (pdf_page->document->render_cache != NULL &&
+      render_cached(pdf_page, cairo, region, prerender, &error) == true) {
+    if (error == ZATHURA_ERROR_OK) {
+      render_recolor(pdf_page, cairo, region);
+    }
+    return error;
+  }
+
+  return render_page(pdf_page, cairo, region, true);
+}
 
 zathura_error_t
 pdf_page_render_cairo(zathura_page_t* page, void* data, cairo_t*
@@ -10,12 +418,32 @@ pdf_page_render_cairo(zathura_page_t* page, void* data, cairo_t*
     return ZATHURA_ERROR_INVALID_ARGUMENTS;
   }
 
-  PopplerPage* poppler_page = data;
-  if (printing == false) {
-    poppler_page_render(poppler_page, cairo);
-  } else {
+  pdf_page_t* pdf_page = data;
+
+  if (printing == true) {
+    PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+    if (poppler_page == NULL) {
+      return ZATHURA_ERROR_UNKNOWN;
+    }
+
     poppler_page_render_for_printing(poppler_page, cairo);
+    g_object_unref(poppler_page);
+
+    return ZATHURA_ERROR_OK;
   }
 
-  return ZATHURA_ERROR_OK;
+  const double width  = zathura_page_get_width(page);
+  const double height = zathura_page_get_height(page);
+
+  zathura_rectangle_t region;
+  if (render_get_visible_region(cairo, width, height, &region) == false) {
+    return ZATHURA_ERROR_OK;
+  }
+
+  /* zathura renders one page at a time, so the workers render the pages
+   * next to it while it is shown */
+  const bool prerender = pdf_page->document->pool != NULL &&
+    region.x1 == 0 && region.y1 == 0 && region.x2 == width && region.y2 == height;
+
+  return render_full(pdf_page, cairo, region, prerender);
 }
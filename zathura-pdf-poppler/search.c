@@ -2,25 +2,400 @@
 
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <girara/utils.h>
+
 #include "plugin.h"
+#include "search.h"
+#include "text.h"
 
-girara_list_t*
-pdf_page_search_text(zathura_page_t* page, void* data, const
-    char* text, zathura_error_t* error)
+struct pdf_search_state_s {
+  char* query; /**< Search term of the last substring search */
+  pdf_search_flags_t flags; /**< Case sensitivity of the last substring search */
+  GArray* positions; /**< Positions of all occurrences of the last search term */
+  gunichar* normalized; /**< Normalized page text for case-sensitive searches */
+  size_t normalized_length; /**< Number of characters in normalized */
+  guint32* normalized_map; /**< Index in the page text of every character in
+                                normalized (NULL if both are the same) */
+  GMutex lock; /**< Protects the fields above */
+};
+
+/* A match given as first and last character of the page text */
+typedef struct search_match_s {
+  size_t first; /**< First character */
+  size_t last; /**< Last character */
+} search_match_t;
+
+/* Returns the first position at or after start where needle occurs in
+ * haystack or length if there is none. Candidates are found by comparing the
+ * first and the last character of the needle four positions at a time. */
+static size_t
+search_find(const gunichar* haystack, size_t length, const gunichar* needle,
+    size_t n, size_t start)
 {
-  if (page == NULL || data == NULL || text == NULL || strlen(text) == 0) {
-    if (error != NULL) {
-      *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+  if (n == 0 || n > length) {
+    return length;
+  }
+
+  const size_t end = length - n + 1;
+  size_t i         = start;
+
+#ifdef __SSE2__
+  const __m128i first = _mm_set1_epi32((int) needle[0]);
+  const __m128i last  = _mm_set1_epi32((int) needle[n - 1]);
+
+  for (; i + 4 <= end; i += 4) {
+    const __m128i block_first = _mm_loadu_si128((const __m128i*) (haystack + i));
+    const __m128i block_last  = _mm_loadu_si128((const __m128i*) (haystack + i + n - 1));
+    const __m128i equal       = _mm_and_si128(_mm_cmpeq_epi32(block_first, first),
+        _mm_cmpeq_epi32(block_last, last));
+
+    /* every candidate sets four bits of the mask */
+    gulong mask = (gulong) _mm_movemask_epi8(equal);
+    gint bit    = -1;
+    while ((bit = g_bit_nth_lsf(mask, bit)) != -1) {
+      const size_t candidate = i + bit / 4;
+      if (memcmp(haystack + candidate, needle, sizeof(gunichar) * n) == 0) {
+        return candidate;
+      }
+      bit += 3;
     }
-    goto error_ret;
+  }
+#endif
+
+  for (; i < end; i++) {
+    if (haystack[i] == needle[0] && haystack[i + n - 1] == needle[n - 1] &&
+        memcmp(haystack + i, needle, sizeof(gunichar) * n) == 0) {
+      return i;
+    }
+  }
+
+  return length;
+}
+
+static bool
+search_is_word(const gunichar* haystack, size_t length, size_t start, size_t end)
+{
+  return (start == 0 || g_unichar_isalnum(haystack[start - 1]) == FALSE) &&
+    (end == length || g_unichar_isalnum(haystack[end]) == FALSE);
+}
+
+static pdf_search_state_t*
+search_get_state(pdf_page_t* pdf_page)
+{
+  g_mutex_lock(&pdf_page->lock);
+  if (pdf_page->search_state == NULL) {
+    pdf_search_state_t* state = g_malloc0(sizeof(pdf_search_state_t));
+    g_mutex_init(&state->lock);
+    pdf_page->search_state = state;
+  }
+  pdf_search_state_t* state = pdf_page->search_state;
+  g_mutex_unlock(&pdf_page->lock);
+
+  return state;
+}
+
+static zathura_error_t
+search_substring(const pdf_text_page_t* text_page, pdf_search_state_t* state,
+    const char* text, pdf_search_flags_t flags, GArray* matches)
+{
+  const pdf_search_flags_t case_flags = flags & PDF_SEARCH_CASE_SENSITIVE;
+
+  size_t length   = 0;
+  gunichar* query = pdf_text_fold(text, &length, NULL);
+
+  g_mutex_lock(&state->lock);
+
+  /* a term that extends the previous one can only occur where the previous
+   * one did, so only those positions are checked again */
+  const bool narrow = state->query != NULL && state->flags == case_flags &&
+    g_str_has_prefix(text, state->query) == TRUE;
+
+  /* an exact match is also a match of the folded texts */
+  const bool possible = length > 0 &&
+    pdf_text_page_may_contain(text_page, query, length) == true;
+
+  const gunichar* haystack = text_page->folded;
+  size_t haystack_length   = text_page->folded_length;
+  const guint32* origins   = text_page->origins;
+
+  if (case_flags != 0) {
+    if (state->normalized == NULL) {
+      state->normalized = pdf_text_normalize(text_page->text,
+          &state->normalized_length, &state->normalized_map);
+    }
+
+    g_free(query);
+    query           = pdf_text_normalize(text, &length, NULL);
+    haystack        = state->normalized;
+    haystack_length = state->normalized_length;
+    origins         = state->normalized_map;
+  }
+
+  /* all occurrences are kept, including overlapping ones and those that are
+   * not whole words, so the next term can be narrowed from them */
+  GArray* positions = g_array_new(FALSE, FALSE, sizeof(guint32));
+  if (possible == true && narrow == true) {
+    for (guint i = 0; i < state->positions->len; i++) {
+      const guint32 position = g_array_index(state->positions, guint32, i);
+      if (position + length <= haystack_length &&
+          memcmp(haystack + position, query, sizeof(gunichar) * length) == 0) {
+        g_array_append_val(positions, position);
+      }
+    }
+  } else if (possible == true) {
+    for (size_t start = search_find(haystack, haystack_length, query, length, 0);
+        start < haystack_length;
+        start = search_find(haystack, haystack_length, query, length, start + 1)) {
+      const guint32 position = start;
+      g_array_append_val(positions, position);
+    }
+  }
+
+  size_t next = 0;
+  for (guint i = 0; i < positions->len; i++) {
+    const size_t start = g_array_index(positions, guint32, i);
+    const size_t end   = start + length;
+
+    /* matches do not overlap */
+    if (start < next) {
+      continue;
+    }
+
+    if ((flags & PDF_SEARCH_WHOLE_WORD) != 0 &&
+        search_is_word(haystack, haystack_length, start, end) == false) {
+      continue;
+    }
+
+    search_match_t match = {
+      .first = origins != NULL ? origins[start] : start,
+      .last  = origins != NULL ? origins[end - 1] : end - 1
+    };
+    g_array_append_val(matches, match);
+
+    next = end;
+  }
+
+  g_free(state->query);
+  if (state->positions != NULL) {
+    g_array_free(state->positions, TRUE);
+  }
+  state->query     = g_strdup(text);
+  state->flags     = case_flags;
+  state->positions = positions;
+
+  g_mutex_unlock(&state->lock);
+
+  g_free(query);
+
+  return ZATHURA_ERROR_OK;
+}
+
+/* Returns the compiled expression. The last one is kept by the document, since
+ * the same expression is searched on every page. */
+static GRegex*
+search_get_regex(pdf_document_t* pdf_document, const char* text, pdf_search_flags_t flags)
+{
+  char* pattern = (flags & PDF_SEARCH_WHOLE_WORD) != 0 ?
+    g_strdup_printf("\\b(?:%s)\\b", text) : g_strdup(text);
+  const GRegexCompileFlags compile_flags = (flags & PDF_SEARCH_CASE_SENSITIVE) != 0 ?
+    G_REGEX_OPTIMIZE : G_REGEX_OPTIMIZE | G_REGEX_CASELESS;
+
+  GRegex* regex = NULL;
+
+  g_mutex_lock(&pdf_document->lock);
+  if (pdf_document->search_regex != NULL &&
+      g_regex_get_compile_flags(pdf_document->search_regex) == compile_flags &&
+      g_strcmp0(g_regex_get_pattern(pdf_document->search_regex), pattern) == 0) {
+    regex = g_regex_ref(pdf_document->search_regex);
+  }
+  g_mutex_unlock(&pdf_document->lock);
+
+  if (regex == NULL) {
+    GError* error = NULL;
+    regex         = g_regex_new(pattern, compile_flags, 0, &error);
+    if (regex == NULL) {
+      girara_debug("Invalid regular expression '%s': %s", text, error->message);
+      g_error_free(error);
+    } else {
+      g_mutex_lock(&pdf_document->lock);
+      if (pdf_document->search_regex != NULL) {
+        g_regex_unref(pdf_document->search_regex);
+      }
+      pdf_document->search_regex = g_regex_ref(regex);
+      g_mutex_unlock(&pdf_document->lock);
+    }
+  }
+
+  g_free(pattern);
+
+  return regex;
+}
+
+static zathura_error_t
+search_regex(pdf_document_t* pdf_document, const pdf_text_page_t* text_page,
+    const char* text, pdf_search_flags_t flags, GArray* matches)
+{
+  GRegex* regex = search_get_regex(pdf_document, text, flags);
+  if (regex == NULL) {
+    return ZATHURA_ERROR_INVALID_ARGUMENTS;
+  }
+
+  /* matches are reported in order, so byte offsets are converted to
+   * character offsets incrementally */
+  const char* cursor   = text_page->text;
+  size_t cursor_offset = 0;
+
+  GMatchInfo* match_info = NULL;
+  g_regex_match(regex, text_page->text, 0, &match_info);
+  while (g_match_info_matches(match_info) == TRUE) {
+    gint start = 0;
+    gint end   = 0;
+    if (g_match_info_fetch_pos(match_info, 0, &start, &end) == TRUE && end > start) {
+      cursor_offset += g_utf8_pointer_to_offset(cursor, text_page->text + start);
+      cursor         = text_page->text + start;
+
+      search_match_t match = {
+        .first = cursor_offset,
+        .last  = cursor_offset + g_utf8_pointer_to_offset(cursor, text_page->text + end) - 1
+      };
+      g_array_append_val(matches, match);
+    }
+
+    g_match_info_next(match_info, NULL);
+  }
+
+  g_match_info_free(match_info);
+  g_regex_unref(regex);
+
+  return ZATHURA_ERROR_OK;
+}
+
+/* Adds the rectangles of a match. Glyph boxes are in page space with the
+ * origin at the top left; a match that spans several lines gets one
+ * rectangle per line. */
+static void
+search_append_rectangles(girara_list_t* list, const float* boxes, const search_match_t* match)
+{
+  zathura_rectangle_t* rectangle = NULL;
+
+  for (size_t i = match->first; i <= match->last; i++) {
+    const float* box = boxes + 4 * i;
+
+    if (rectangle != NULL && box[1] >= rectangle->y2) {
+      girara_list_append(list, rectangle);
+      rectangle = NULL;
+    }
+
+    if (rectangle == NULL) {
+      rectangle     = g_malloc0(sizeof(zathura_rectangle_t));
+      rectangle->x1 = box[0];
+      rectangle->y1 = box[1];
+      rectangle->x2 = box[2];
+      rectangle->y2 = box[3];
+      continue;
+    }
+
+    rectangle->x1 = MIN(rectangle->x1, box[0]);
+    rectangle->y1 = MIN(rectangle->y1, box[1]);
+    rectangle->x2 = MAX(rectangle->x2, box[2]);
+    rectangle->y2 = MAX(rectangle->y2, box[3]);
+  }
+
+  if (rectangle != NULL) {
+    girara_list_append(list, rectangle);
+  }
+}
+
+/* Searches the extracted text of the page. status is set to
+ * ZATHURA_ERROR_NOT_IMPLEMENTED if the page has to be searched by poppler. */
+static girara_list_t*
+search_text(pdf_page_t* pdf_page, const char* text, pdf_search_flags_t flags,
+    zathura_error_t* status)
+{
+  pdf_text_index_t* text_index     = pdf_page->document->text_index;
+  const pdf_text_page_t* text_page = NULL;
+  pdf_text_page_t* extracted       = NULL;
+
+  if (text_index != NULL) {
+    text_page = pdf_text_index_get_page(text_index, pdf_page);
+  } else if (flags != PDF_SEARCH_DEFAULT) {
+    /* without an index the text is extracted for this search only */
+    PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+    if (poppler_page != NULL) {
+      extracted = pdf_text_page_new(poppler_page, true);
+      g_object_unref(poppler_page);
+    }
+    text_page = extracted;
+  }
+
+  if (text_page == NULL) {
+    *status = ZATHURA_ERROR_NOT_IMPLEMENTED;
+    return NULL;
   }
 
-  PopplerPage* poppler_page = data;
+  GArray* matches = g_array_new(FALSE, FALSE, sizeof(search_match_t));
+  if ((flags & PDF_SEARCH_REGEX) != 0) {
+    *status = search_regex(pdf_page->document, text_page, text, flags, matches);
+  } else {
+    *status = search_substring(text_page, search_get_state(pdf_page), text, flags,
+        matches);
+  }
+
+  girara_list_t* list = NULL;
+  if (*status == ZATHURA_ERROR_OK && matches->len > 0) {
+    /* the glyph boxes are only needed for pages with matches */
+    const float* boxes = extracted != NULL ? extracted->boxes :
+      pdf_text_index_get_boxes(text_index, pdf_page);
+    if (boxes == NULL) {
+      *status = ZATHURA_ERROR_NOT_IMPLEMENTED;
+    } else {
+      list = girara_list_new2(g_free);
+      for (guint i = 0; i < matches->len; i++) {
+        search_append_rectangles(list, boxes, &g_array_index(matches, search_match_t, i));
+      }
+    }
+  }
+
+  g_array_free(matches, TRUE);
+  pdf_text_page_free(extracted);
+
+  return list;
+}
+
+static girara_list_t*
+search_poppler(zathura_page_t* page, pdf_page_t* pdf_page, const char* text,
+    pdf_search_flags_t flags, zathura_error_t* error)
+{
   GList* results            = NULL;
   girara_list_t* list       = NULL;
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+
+  if (poppler_page == NULL) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_UNKNOWN;
+    }
+    goto error_ret;
+  }
 
   /* search text */
+#if POPPLER_CHECK_VERSION(0, 22, 0)
+  PopplerFindFlags find_flags = POPPLER_FIND_DEFAULT;
+  if ((flags & PDF_SEARCH_CASE_SENSITIVE) != 0) {
+    find_flags |= POPPLER_FIND_CASE_SENSITIVE;
+  }
+  if ((flags & PDF_SEARCH_WHOLE_WORD) != 0) {
+    find_flags |= POPPLER_FIND_WHOLE_WORDS_ONLY;
+  }
+  results = poppler_page_find_text_with_options(poppler_page, text, find_flags);
+#else
+  (void) flags;
   results = poppler_page_find_text(poppler_page, text);
+#endif
+  g_object_unref(poppler_page);
   if (results == NULL || g_list_length(results) == 0) {
     if (error != NULL) {
       *error = ZATHURA_ERROR_UNKNOWN;
@@ -67,3 +442,91 @@ error_ret:
 
   return NULL;
 }
+
+girara_list_t*
+pdf_page_search_text_with_options(zathura_page_t* page, pdf_page_t* pdf_page,
+    const char* text, pdf_search_flags_t flags, zathura_error_t* error)
+{
+  if (page == NULL || pdf_page == NULL || text == NULL || strlen(text) == 0) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+    }
+    return NULL;
+  }
+
+  /* answer from the extracted text and only let poppler search pages the
+   * index cannot handle */
+  zathura_error_t status = ZATHURA_ERROR_NOT_IMPLEMENTED;
+  girara_list_t* list    = search_text(pdf_page, text, flags, &status);
+
+  if (status == ZATHURA_ERROR_NOT_IMPLEMENTED && (flags & PDF_SEARCH_REGEX) == 0) {
+    return search_poppler(page, pdf_page, text, flags, error);
+  }
+
+  if (list == NULL && error != NULL) {
+    *error = status == ZATHURA_ERROR_OK ? ZATHURA_ERROR_UNKNOWN : status;
+  }
+
+  return list;
+}
+
+girara_list_t*
+pdf_page_search_text(zathura_page_t* page, void* data, const
+    char* text, zathura_error_t* error)
+{
+  pdf_page_t* pdf_page = data;
+  if (pdf_page == NULL) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_INVALID_ARGUMENTS;
+    }
+    return NULL;
+  }
+
+  return pdf_page_search_text_with_options(page, pdf_page, text,
+      pdf_page->document->search_flags, error);
+}
+
+pdf_search_flags_t
+pdf_search_parse_flags(const char* value)
+{
+  if (value == NULL) {
+    return PDF_SEARCH_DEFAULT;
+  }
+
+  pdf_search_flags_t flags = PDF_SEARCH_DEFAULT;
+  char** modes             = g_strsplit(value, ",", -1);
+
+  for (char** mode = modes; *mode != NULL; mode++) {
+    g_strstrip(*mode);
+    if (g_strcmp0(*mode, "case-sensitive") == 0) {
+      flags |= PDF_SEARCH_CASE_SENSITIVE;
+    } else if (g_strcmp0(*mode, "whole-word") == 0) {
+      flags |= PDF_SEARCH_WHOLE_WORD;
+    } else if (g_strcmp0(*mode, "regex") == 0) {
+      flags |= PDF_SEARCH_REGEX;
+    } else if (**mode != '\0') {
+      girara_warning("Unknown search mode '%s'", *mode);
+    }
+  }
+
+  g_strfreev(modes);
+
+  return flags;
+}
+
+void
+pdf_search_state_free(pdf_search_state_t* state)
+{
+  if (state == NULL) {
+    return;
+  }
+
+  g_free(state->query);
+  if (state->positions != NULL) {
+    g_array_free(state->positions, TRUE);
+  }
+  g_free(state->normalized);
+  g_free(state->normalized_map);
+  g_mutex_clear(&state->lock);
+  g_free(state);
+}
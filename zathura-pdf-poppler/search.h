@@ -0,0 +1,54 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "plugin.h"
+
+/**
+ * Search modes
+ */
+typedef enum pdf_search_flags_e {
+  PDF_SEARCH_DEFAULT        = 0, /**< Case-insensitive substring search */
+  PDF_SEARCH_CASE_SENSITIVE = 1 << 0, /**< Match the case of the text */
+  PDF_SEARCH_WHOLE_WORD     = 1 << 1, /**< Only match whole words */
+  PDF_SEARCH_REGEX          = 1 << 2 /**< Treat the text as regular expression */
+} pdf_search_flags_t;
+
+typedef struct pdf_search_state_s pdf_search_state_t;
+
+/**
+ * Searches for a text on a page. The occurrences of the search term are kept
+ * with the page, so a following search for a term that extends it only
+ * checks these positions.
+ *
+ * @param page The page
+ * @param pdf_page Internal page representation
+ * @param text Search term (or regular expression with PDF_SEARCH_REGEX)
+ * @param flags Search mode
+ * @param error Set to an error value (see zathura_error_t) if an
+ *   error occurred
+ * @return List of rectangles of the matches or NULL if there are no matches
+ *   or an error occurred
+ */
+GIRARA_HIDDEN girara_list_t* pdf_page_search_text_with_options(zathura_page_t* page,
+    pdf_page_t* pdf_page, const char* text, pdf_search_flags_t flags,
+    zathura_error_t* error);
+
+/**
+ * Frees the search state of a page
+ *
+ * @param state The search state
+ */
+GIRARA_HIDDEN void pdf_search_state_free(pdf_search_state_t* state);
+
+/**
+ * Parses a comma separated list of search modes ("case-sensitive",
+ * "whole-word" and "regex")
+ *
+ * @param value The list or NULL
+ * @return The search flags
+ */
+GIRARA_HIDDEN pdf_search_flags_t pdf_search_parse_flags(const char* value);
+
+#endif // SEARCH_H
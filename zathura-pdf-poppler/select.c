@@ -1,6 +1,52 @@
 /* See LICENSE file for license and copyright information */
 
 #include "plugin.h"
+#include "grid.h"
+#include "text.h"
+
+/* Selects the text from the glyph closest to the first corner of the
+ * rectangle to the glyph closest to the second one, like a glyph selection in
+ * poppler. indexed is set to false if the page cannot be answered from the
+ * index. */
+static char*
+select_text_index(pdf_text_index_t* text_index, pdf_page_t* pdf_page,
+    zathura_rectangle_t rectangle, bool* indexed)
+{
+  *indexed = false;
+
+  const pdf_text_page_t* text_page = pdf_text_index_get_page(text_index, pdf_page);
+  pdf_grid_t* grid                 = pdf_text_index_get_grid(text_index, pdf_page);
+  if (text_page == NULL || grid == NULL) {
+    return NULL;
+  }
+
+  *indexed = true;
+
+  /* nothing is selected if the rectangle does not touch any glyph */
+  GArray* glyphs = g_array_new(FALSE, FALSE, sizeof(guint32));
+  pdf_grid_query(grid, rectangle.x1, rectangle.y1, rectangle.x2, rectangle.y2, glyphs);
+  const bool empty = glyphs->len == 0;
+  g_array_free(glyphs, TRUE);
+
+  if (empty == true) {
+    return g_strdup("");
+  }
+
+  size_t first = 0;
+  size_t last  = 0;
+  pdf_grid_nearest(grid, rectangle.x1, rectangle.y1, &first);
+  pdf_grid_nearest(grid, rectangle.x2, rectangle.y2, &last);
+  if (first > last) {
+    const size_t tmp = first;
+    first = last;
+    last  = tmp;
+  }
+
+  const char* start = g_utf8_offset_to_pointer(text_page->text, first);
+  const char* end   = g_utf8_offset_to_pointer(start, last - first + 1);
+
+  return g_strndup(start, end - start);
+}
 
 char*
 pdf_page_get_text(zathura_page_t* page, void* data,
@@ -13,14 +59,35 @@ pdf_page_get_text(zathura_page_t* page, void* data,
     return NULL;
   }
 
+  pdf_page_t* pdf_page = data;
+
+  /* answer from the cached text and glyph boxes of the page */
+  if (pdf_page->document->text_index != NULL) {
+    bool indexed = false;
+    char* text   = select_text_index(pdf_page->document->text_index, pdf_page,
+        rectangle, &indexed);
+    if (indexed == true) {
+      return text;
+    }
+  }
+
   PopplerRectangle rect = {
     .x1 = rectangle.x1,
     .x2 = rectangle.x2,
     .y1 = rectangle.y1,
     .y2 = rectangle.y2
   };
-  PopplerPage* poppler_page = data;
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    if (error != NULL) {
+      *error = ZATHURA_ERROR_UNKNOWN;
+    }
+    return NULL;
+  }
 
   /* get selected text */
-  return poppler_page_get_selected_text(poppler_page, POPPLER_SELECTION_GLYPH, &rect);
+  char* text = poppler_page_get_selected_text(poppler_page, POPPLER_SELECTION_GLYPH, &rect);
+  g_object_unref(poppler_page);
+
+  return text;
 }
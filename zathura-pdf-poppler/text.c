@@ -0,0 +1,449 @@
+/* See LICENSE file for license and copyright information */
+
+#include <string.h>
+
+#include "grid.h"
+#include "text.h"
+
+#define BIGRAM_BITS (PDF_TEXT_BIGRAM_WORDS * 64)
+
+/* Number of pages extracted by a single background job */
+#define EXTRACT_JOB_PAGES 8
+
+struct pdf_text_index_s {
+  pdf_text_page_t** pages; /**< Text by page index (NULL if not extracted) */
+  unsigned int n_pages; /**< Number of pages */
+  unsigned int n_indexed; /**< Number of extracted pages */
+  GMutex lock; /**< Protects pages and the boxes and grid of every page */
+};
+
+typedef struct text_extract_job_s {
+  pdf_text_index_t* index; /**< The index */
+  unsigned int first; /**< First page to extract */
+  unsigned int last; /**< Page after the last page to extract */
+} text_extract_job_t;
+
+static unsigned int
+bigram_hash(gunichar first, gunichar second)
+{
+  return ((first * 31) ^ second) % BIGRAM_BITS;
+}
+
+static float*
+text_page_load_boxes(size_t length, PopplerPage* poppler_page)
+{
+  PopplerRectangle* rectangles = NULL;
+  guint n_rectangles           = 0;
+
+  if (poppler_page_get_text_layout(poppler_page, &rectangles, &n_rectangles) == FALSE) {
+    return NULL;
+  }
+
+  /* the layout has one rectangle per character of poppler_page_get_text */
+  if (n_rectangles != length) {
+    g_free(rectangles);
+    return NULL;
+  }
+
+  float* boxes = g_malloc(sizeof(float) * 4 * MAX(n_rectangles, 1));
+  for (guint i = 0; i < n_rectangles; i++) {
+    boxes[4 * i + 0] = rectangles[i].x1;
+    boxes[4 * i + 1] = rectangles[i].y1;
+    boxes[4 * i + 2] = rectangles[i].x2;
+    boxes[4 * i + 3] = rectangles[i].y2;
+  }
+  g_free(rectangles);
+
+  return boxes;
+}
+
+pdf_text_page_t*
+pdf_text_page_new(PopplerPage* poppler_page, bool load_boxes)
+{
+  if (poppler_page == NULL) {
+    return NULL;
+  }
+
+  char* text = poppler_page_get_text(poppler_page);
+  if (text == NULL) {
+    text = g_strdup("");
+  }
+
+  pdf_text_page_t* text_page = pdf_text_page_new_from_data(text, NULL, 0);
+  if (load_boxes == true) {
+    text_page->boxes        = text_page_load_boxes(text_page->length, poppler_page);
+    text_page->boxes_loaded = true;
+  }
+
+  return text_page;
+}
+
+pdf_text_page_t*
+pdf_text_page_new_from_data(char* text, float* boxes, size_t n_boxes)
+{
+  if (text == NULL) {
+    g_free(boxes);
+    return NULL;
+  }
+
+  pdf_text_page_t* text_page = g_malloc0(sizeof(pdf_text_page_t));
+  text_page->text            = text;
+  text_page->length          = g_utf8_strlen(text, -1);
+  text_page->folded          = pdf_text_fold(text, &text_page->folded_length,
+      &text_page->origins);
+
+  if (boxes != NULL) {
+    if (n_boxes == text_page->length) {
+      text_page->boxes = boxes;
+    } else {
+      g_free(boxes);
+    }
+    text_page->boxes_loaded = true;
+  }
+
+  for (size_t i = 1; i < text_page->folded_length; i++) {
+    const unsigned int bit = bigram_hash(text_page->folded[i - 1], text_page->folded[i]);
+    text_page->bigrams[bit / 64] |= G_GUINT64_CONSTANT(1) << (bit % 64);
+  }
+
+  return text_page;
+}
+
+void
+pdf_text_page_free(pdf_text_page_t* text_page)
+{
+  if (text_page == NULL) {
+    return;
+  }
+
+  g_free(text_page->text);
+  g_free(text_page->folded);
+  g_free(text_page->origins);
+  g_free(text_page->boxes);
+  pdf_grid_free(text_page->grid);
+  g_free(text_page);
+}
+
+static void
+text_extract_job(PopplerDocument* poppler_document, void* data)
+{
+  text_extract_job_t* job = data;
+
+  for (unsigned int i = job->first; poppler_document != NULL && i < job->last; i++) {
+    if (pdf_text_index_peek_page(job->index, i) != NULL) {
+      continue;
+    }
+
+    PopplerPage* poppler_page = poppler_document_get_page(poppler_document, i);
+    if (poppler_page == NULL) {
+      continue;
+    }
+
+    pdf_text_index_add_page(job->index, i, pdf_text_page_new(poppler_page, true));
+    g_object_unref(poppler_page);
+  }
+
+  g_free(job);
+}
+
+pdf_text_index_t*
+pdf_text_index_new(unsigned int n_pages)
+{
+  pdf_text_index_t* index = g_malloc0(sizeof(pdf_text_index_t));
+  index->pages            = g_malloc0(sizeof(pdf_text_page_t*) * MAX(n_pages, 1));
+  index->n_pages          = n_pages;
+  g_mutex_init(&index->lock);
+
+  return index;
+}
+
+void
+pdf_text_index_free(pdf_text_index_t* index)
+{
+  if (index == NULL) {
+    return;
+  }
+
+  for (unsigned int i = 0; i < index->n_pages; i++) {
+    pdf_text_page_free(index->pages[i]);
+  }
+
+  g_free(index->pages);
+  g_mutex_clear(&index->lock);
+  g_free(index);
+}
+
+const pdf_text_page_t*
+pdf_text_index_get_page(pdf_text_index_t* index, pdf_page_t* pdf_page)
+{
+  if (index == NULL || pdf_page == NULL || pdf_page->index >= index->n_pages) {
+    return NULL;
+  }
+
+  g_mutex_lock(&index->lock);
+  pdf_text_page_t* text_page = index->pages[pdf_page->index];
+  g_mutex_unlock(&index->lock);
+
+  if (text_page != NULL) {
+    return text_page;
+  }
+
+  /* extract without holding the lock; pages are immutable once indexed */
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    return NULL;
+  }
+
+  text_page = pdf_text_page_new(poppler_page, false);
+  g_object_unref(poppler_page);
+
+  pdf_text_index_add_page(index, pdf_page->index, text_page);
+
+  return pdf_text_index_peek_page(index, pdf_page->index);
+}
+
+const pdf_text_page_t*
+pdf_text_index_peek_page(pdf_text_index_t* index, unsigned int page)
+{
+  if (index == NULL || page >= index->n_pages) {
+    return NULL;
+  }
+
+  g_mutex_lock(&index->lock);
+  const pdf_text_page_t* text_page = index->pages[page];
+  g_mutex_unlock(&index->lock);
+
+  return text_page;
+}
+
+void
+pdf_text_index_add_page(pdf_text_index_t* index, unsigned int page,
+    pdf_text_page_t* text_page)
+{
+  if (index == NULL || text_page == NULL) {
+    return;
+  }
+
+  if (page >= index->n_pages) {
+    pdf_text_page_free(text_page);
+    return;
+  }
+
+  g_mutex_lock(&index->lock);
+  if (index->pages[page] == NULL) {
+    index->pages[page] = text_page;
+    index->n_indexed++;
+    text_page = NULL;
+  }
+  g_mutex_unlock(&index->lock);
+
+  /* the page was indexed in the meantime */
+  pdf_text_page_free(text_page);
+}
+
+unsigned int
+pdf_text_index_get_n_pages(pdf_text_index_t* index)
+{
+  return index != NULL ? index->n_pages : 0;
+}
+
+bool
+pdf_text_index_is_complete(pdf_text_index_t* index)
+{
+  if (index == NULL) {
+    return false;
+  }
+
+  g_mutex_lock(&index->lock);
+  const bool complete = index->n_indexed == index->n_pages;
+  g_mutex_unlock(&index->lock);
+
+  return complete;
+}
+
+void
+pdf_text_index_extract(pdf_text_index_t* index, pdf_pool_t* pool)
+{
+  if (index == NULL || pool == NULL) {
+    return;
+  }
+
+  for (unsigned int first = 0; first < index->n_pages; first += EXTRACT_JOB_PAGES) {
+    text_extract_job_t* job = g_malloc0(sizeof(text_extract_job_t));
+    job->index              = index;
+    job->first              = first;
+    job->last               = MIN(first + EXTRACT_JOB_PAGES, index->n_pages);
+
+    pdf_pool_push(pool, NULL, text_extract_job, job, false);
+  }
+}
+
+const float*
+pdf_text_index_get_boxes(pdf_text_index_t* index, pdf_page_t* pdf_page)
+{
+  const pdf_text_page_t* text_page = pdf_text_index_get_page(index, pdf_page);
+  if (text_page == NULL) {
+    return NULL;
+  }
+
+  /* the boxes and the grid are the only parts of an indexed page that are
+   * set later */
+  pdf_text_page_t* entry = (pdf_text_page_t*) text_page;
+
+  g_mutex_lock(&index->lock);
+  const bool loaded        = entry->boxes_loaded;
+  const float* boxes_known = entry->boxes;
+  g_mutex_unlock(&index->lock);
+
+  if (loaded == true) {
+    return boxes_known;
+  }
+
+  PopplerPage* poppler_page = pdf_page_get_poppler_page(pdf_page);
+  if (poppler_page == NULL) {
+    return NULL;
+  }
+
+  float* boxes = text_page_load_boxes(entry->length, poppler_page);
+  g_object_unref(poppler_page);
+
+  g_mutex_lock(&index->lock);
+  if (entry->boxes_loaded == false) {
+    entry->boxes        = boxes;
+    entry->boxes_loaded = true;
+  } else {
+    g_free(boxes);
+    boxes = entry->boxes;
+  }
+  g_mutex_unlock(&index->lock);
+
+  return boxes;
+}
+
+static gunichar*
+text_normalize(const char* text, bool lower, size_t* length, guint32** origins)
+{
+  if (text == NULL || length == NULL) {
+    return NULL;
+  }
+
+  const size_t size = strlen(text);
+  GArray* result    = g_array_sized_new(FALSE, FALSE, sizeof(gunichar), size + 1);
+  GArray* map       = g_array_sized_new(FALSE, FALSE, sizeof(guint32), size + 1);
+  bool identity     = true;
+
+  guint32 position = 0;
+  for (const char* p = text; *p != '\0'; p = g_utf8_next_char(p), position++) {
+    const gunichar c = g_utf8_get_char(p);
+
+    /* ASCII is already normalized */
+    if (c < 0x80) {
+      const gunichar value = lower == true ? (gunichar) g_ascii_tolower(c) : c;
+      g_array_append_val(result, value);
+      g_array_append_val(map, position);
+      continue;
+    }
+
+    gchar buffer[6];
+    const gint n      = g_unichar_to_utf8(c, buffer);
+    gchar* normalized = g_utf8_normalize(buffer, n, G_NORMALIZE_NFKC);
+    if (normalized == NULL) {
+      const gunichar value = lower == true ? g_unichar_tolower(c) : c;
+      g_array_append_val(result, value);
+      g_array_append_val(map, position);
+      continue;
+    }
+
+    /* compatibility decompositions like ligatures expand to several
+     * characters, which all map back to the original one */
+    unsigned int expanded = 0;
+    for (const char* q = normalized; *q != '\0'; q = g_utf8_next_char(q), expanded++) {
+      const gunichar part  = g_utf8_get_char(q);
+      const gunichar value = lower == true ? g_unichar_tolower(part) : part;
+      g_array_append_val(result, value);
+      g_array_append_val(map, position);
+    }
+    if (expanded != 1) {
+      identity = false;
+    }
+
+    g_free(normalized);
+  }
+
+  *length = result->len;
+
+  if (origins != NULL) {
+    *origins = identity == true ? NULL : (guint32*) g_array_free(map, FALSE);
+  }
+  if (origins == NULL || identity == true) {
+    g_array_free(map, TRUE);
+  }
+
+  return (gunichar*) g_array_free(result, FALSE);
+}
+
+pdf_grid_t*
+pdf_text_index_get_grid(pdf_text_index_t* index, pdf_page_t* pdf_page)
+{
+  const float* boxes = pdf_text_index_get_boxes(index, pdf_page);
+  if (boxes == NULL) {
+    return NULL;
+  }
+
+  pdf_text_page_t* entry = (pdf_text_page_t*) pdf_text_index_peek_page(index, pdf_page->index);
+
+  g_mutex_lock(&index->lock);
+  pdf_grid_t* grid = entry->grid;
+  g_mutex_unlock(&index->lock);
+
+  if (grid != NULL) {
+    return grid;
+  }
+
+  grid = pdf_grid_new(boxes, entry->length);
+
+  g_mutex_lock(&index->lock);
+  if (entry->grid == NULL) {
+    entry->grid = grid;
+  } else {
+    pdf_grid_free(grid);
+    grid = entry->grid;
+  }
+  g_mutex_unlock(&index->lock);
+
+  return grid;
+}
+
+gunichar*
+pdf_text_fold(const char* text, size_t* length, guint32** origins)
+{
+  return text_normalize(text, true, length, origins);
+}
+
+gunichar*
+pdf_text_normalize(const char* text, size_t* length, guint32** origins)
+{
+  return text_normalize(text, false, length, origins);
+}
+
+bool
+pdf_text_page_may_contain(const pdf_text_page_t* text_page, const gunichar* folded,
+    size_t length)
+{
+  if (text_page == NULL || folded == NULL) {
+    return false;
+  }
+
+  if (length > text_page->folded_length) {
+    return false;
+  }
+
+  for (size_t i = 1; i < length; i++) {
+    const unsigned int bit = bigram_hash(folded[i - 1], folded[i]);
+    if ((text_page->bigrams[bit / 64] & (G_GUINT64_CONSTANT(1) << (bit % 64))) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
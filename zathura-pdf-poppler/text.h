@@ -0,0 +1,192 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "plugin.h"
+#include "pool.h"
+
+/* Number of 64 bit words in the character pair filter of a page */
+#define PDF_TEXT_BIGRAM_WORDS 64
+
+/**
+ * Extracted text of a page
+ */
+typedef struct pdf_text_page_s {
+  char* text; /**< Text of the page as returned by poppler (UTF-8) */
+  size_t length; /**< Number of characters in text */
+  gunichar* folded; /**< Normalized and lower-cased text */
+  size_t folded_length; /**< Number of characters in folded */
+  guint32* origins; /**< Index in text of every character in folded (NULL if
+                         both have the same characters) */
+  guint64 bigrams[PDF_TEXT_BIGRAM_WORDS]; /**< Filter of the character pairs in
+                                               folded */
+  float* boxes; /**< Glyph boxes (x1, y1, x2, y2) of every character in text,
+                     loaded on demand */
+  bool boxes_loaded; /**< Set once loading the boxes has been attempted */
+  struct pdf_grid_s* grid; /**< Spatial index of the boxes, built on demand */
+} pdf_text_page_t;
+
+typedef struct pdf_text_index_s pdf_text_index_t;
+
+/**
+ * Creates an empty text index for a document
+ *
+ * @param n_pages Number of pages of the document
+ * @return The index
+ */
+GIRARA_HIDDEN pdf_text_index_t* pdf_text_index_new(unsigned int n_pages);
+
+/**
+ * Frees the text index
+ *
+ * @param index The index
+ */
+GIRARA_HIDDEN void pdf_text_index_free(pdf_text_index_t* index);
+
+/**
+ * Returns the text of a page if it has been indexed
+ *
+ * @param index The index
+ * @param page Page index
+ * @return The text of the page (owned by the index) or NULL
+ */
+GIRARA_HIDDEN const pdf_text_page_t* pdf_text_index_peek_page(pdf_text_index_t* index,
+    unsigned int page);
+
+/**
+ * Adds the text of a page to the index. If the page has been indexed in the
+ * meantime, the given text is freed instead.
+ *
+ * @param index The index
+ * @param page Page index
+ * @param text_page The text of the page (owned by the index afterwards)
+ */
+GIRARA_HIDDEN void pdf_text_index_add_page(pdf_text_index_t* index, unsigned int page,
+    pdf_text_page_t* text_page);
+
+/**
+ * Returns the number of pages of the index
+ *
+ * @param index The index
+ * @return Number of pages
+ */
+GIRARA_HIDDEN unsigned int pdf_text_index_get_n_pages(pdf_text_index_t* index);
+
+/**
+ * Checks if the text of every page has been indexed
+ *
+ * @param index The index
+ * @return true if all pages are indexed
+ */
+GIRARA_HIDDEN bool pdf_text_index_is_complete(pdf_text_index_t* index);
+
+/**
+ * Queues the extraction of all pages that have not been indexed yet on the
+ * worker pool. The workers extract text and glyph boxes with their own
+ * documents.
+ *
+ * @param index The index
+ * @param pool The worker pool
+ */
+GIRARA_HIDDEN void pdf_text_index_extract(pdf_text_index_t* index, pdf_pool_t* pool);
+
+/**
+ * Returns the text of a page and extracts it if it has not been indexed yet
+ *
+ * @param index The index
+ * @param pdf_page The page
+ * @return The text of the page (owned by the index) or NULL if an error
+ *   occurred
+ */
+GIRARA_HIDDEN const pdf_text_page_t* pdf_text_index_get_page(pdf_text_index_t* index,
+    pdf_page_t* pdf_page);
+
+/**
+ * Returns the glyph boxes of a page and loads them if necessary. There are
+ * four coordinates in page space for every character of the page's text.
+ *
+ * @param index The index
+ * @param pdf_page The page
+ * @return The boxes (owned by the index) or NULL if they are not available
+ */
+GIRARA_HIDDEN const float* pdf_text_index_get_boxes(pdf_text_index_t* index,
+    pdf_page_t* pdf_page);
+
+/**
+ * Extracts the text of a page
+ *
+ * @param poppler_page The page
+ * @param load_boxes Set to true to load the glyph boxes as well
+ * @return The text of the page or NULL if an error occurred
+ */
+GIRARA_HIDDEN pdf_text_page_t* pdf_text_page_new(PopplerPage* poppler_page,
+    bool load_boxes);
+
+/**
+ * Creates the text of a page from previously extracted data
+ *
+ * @param text UTF-8 text (owned by the result afterwards)
+ * @param boxes Glyph boxes or NULL (owned by the result afterwards)
+ * @param n_boxes Number of characters the boxes describe; the boxes are
+ *   dropped if it does not match the text
+ * @return The text of the page or NULL if an error occurred
+ */
+GIRARA_HIDDEN pdf_text_page_t* pdf_text_page_new_from_data(char* text, float* boxes,
+    size_t n_boxes);
+
+/**
+ * Frees the text of a page
+ *
+ * @param text_page The text of the page
+ */
+GIRARA_HIDDEN void pdf_text_page_free(pdf_text_page_t* text_page);
+
+/**
+ * Returns a spatial index of the glyph boxes of a page and builds it if
+ * necessary
+ *
+ * @param index The index
+ * @param pdf_page The page
+ * @return The grid (owned by the index) or NULL if the glyph boxes are not
+ *   available
+ */
+GIRARA_HIDDEN struct pdf_grid_s* pdf_text_index_get_grid(pdf_text_index_t* index,
+    pdf_page_t* pdf_page);
+
+/**
+ * Normalizes (NFKC) and lower-cases text
+ *
+ * @param text UTF-8 text
+ * @param length Set to the number of characters of the result
+ * @param origins If not NULL, set to the index in text of every character of
+ *   the result or to NULL if both have the same characters
+ * @return The folded text (needs to be freed with g_free)
+ */
+GIRARA_HIDDEN gunichar* pdf_text_fold(const char* text, size_t* length,
+    guint32** origins);
+
+/**
+ * Normalizes (NFKC) text without changing its case
+ *
+ * @param text UTF-8 text
+ * @param length Set to the number of characters of the result
+ * @param origins If not NULL, set to the index in text of every character of
+ *   the result or to NULL if both have the same characters
+ * @return The normalized text (needs to be freed with g_free)
+ */
+GIRARA_HIDDEN gunichar* pdf_text_normalize(const char* text, size_t* length,
+    guint32** origins);
+
+/**
+ * Checks the character pair filter of a page
+ *
+ * @param text_page The text of the page
+ * @param folded Folded search term
+ * @param length Number of characters of the search term
+ * @return false if the page cannot contain the search term
+ */
+GIRARA_HIDDEN bool pdf_text_page_may_contain(const pdf_text_page_t* text_page,
+    const gunichar* folded, size_t length);
+
+#endif // TEXT_H
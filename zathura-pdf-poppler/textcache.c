@@ -0,0 +1,296 @@
+/* See LICENSE file for license and copyright information */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
+#include <girara/utils.h>
+
+#include "textcache.h"
+
+/* Identifies the format of the cache files */
+#define TEXT_CACHE_MAGIC "ZPPTEXT1"
+#define TEXT_CACHE_MAGIC_SIZE 8
+/* Size of the regions at the beginning and the end of a document that are
+ * hashed for the name of its cache file */
+#define TEXT_CACHE_SAMPLE_SIZE (64 * 1024)
+/* Maximal size of all files in the cache directory */
+#define TEXT_CACHE_MAX_SIZE (256 * 1024 * 1024)
+
+typedef struct text_cache_file_s {
+  char* path; /**< Path of the cache file */
+  goffset size; /**< Size of the file */
+  gint64 mtime; /**< Modification time of the file */
+} text_cache_file_t;
+
+typedef struct text_cache_reader_s {
+  const char* data; /**< Contents of the cache file */
+  gsize size; /**< Size of the contents */
+  gsize offset; /**< Read position */
+} text_cache_reader_t;
+
+static const char*
+text_cache_read(text_cache_reader_t* reader, gsize size)
+{
+  if (size > reader->size - reader->offset) {
+    return NULL;
+  }
+
+  const char* data = reader->data + reader->offset;
+  reader->offset  += size;
+
+  return data;
+}
+
+static bool
+text_cache_read_uint(text_cache_reader_t* reader, guint32* value)
+{
+  const char* data = text_cache_read(reader, sizeof(guint32));
+  if (data == NULL) {
+    return false;
+  }
+
+  memcpy(value, data, sizeof(guint32));
+  return true;
+}
+
+static void
+text_cache_write_uint(GByteArray* array, guint32 value)
+{
+  g_byte_array_append(array, (const guint8*) &value, sizeof(guint32));
+}
+
+static void
+text_cache_update_checksum(GChecksum* checksum, FILE* file, guchar* buffer)
+{
+  const size_t size = fread(buffer, 1, TEXT_CACHE_SAMPLE_SIZE, file);
+  if (size > 0) {
+    g_checksum_update(checksum, buffer, size);
+  }
+}
+
+static gint
+text_cache_file_compare(gconstpointer a, gconstpointer b)
+{
+  const text_cache_file_t* file_a = a;
+  const text_cache_file_t* file_b = b;
+
+  return (file_a->mtime > file_b->mtime) - (file_a->mtime < file_b->mtime);
+}
+
+/* Deletes the least recently used cache files until the files in the
+ * directory fit into TEXT_CACHE_MAX_SIZE. Files are touched when they are
+ * loaded, so their modification time is the time of their last use. */
+static void
+text_cache_prune(const char* directory)
+{
+  GDir* dir = g_dir_open(directory, 0, NULL);
+  if (dir == NULL) {
+    return;
+  }
+
+  GArray* files    = g_array_new(FALSE, FALSE, sizeof(text_cache_file_t));
+  goffset total    = 0;
+  const char* name = NULL;
+  while ((name = g_dir_read_name(dir)) != NULL) {
+    if (g_str_has_suffix(name, ".text") == FALSE) {
+      continue;
+    }
+
+    text_cache_file_t file = { .path = g_build_filename(directory, name, NULL) };
+    struct stat info;
+    if (stat(file.path, &info) != 0) {
+      g_free(file.path);
+      continue;
+    }
+
+    file.size  = info.st_size;
+    file.mtime = info.st_mtime;
+    total     += file.size;
+    g_array_append_val(files, file);
+  }
+  g_dir_close(dir);
+
+  g_array_sort(files, text_cache_file_compare);
+  for (guint i = 0; i < files->len; i++) {
+    text_cache_file_t* file = &g_array_index(files, text_cache_file_t, i);
+    if (total > TEXT_CACHE_MAX_SIZE && g_unlink(file->path) == 0) {
+      girara_debug("Removed text cache %s", file->path);
+      total -= file->size;
+    }
+    g_free(file->path);
+  }
+  g_array_free(files, TRUE);
+}
+
+char*
+pdf_text_cache_get_filename(const char* path)
+{
+  if (path == NULL) {
+    return NULL;
+  }
+
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    return NULL;
+  }
+
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+
+  GChecksum* checksum = g_checksum_new(G_CHECKSUM_SHA256);
+  char* key           = g_strdup_printf("%" G_GUINT64_FORMAT ":%ld.%09ld",
+      (guint64) info.st_size, (long) info.st_mtim.tv_sec, (long) info.st_mtim.tv_nsec);
+  g_checksum_update(checksum, (const guchar*) key, -1);
+  g_free(key);
+
+  /* the trailer at the end changes with every incremental update */
+  guchar* buffer = g_malloc(TEXT_CACHE_SAMPLE_SIZE);
+  text_cache_update_checksum(checksum, file, buffer);
+  if (info.st_size > TEXT_CACHE_SAMPLE_SIZE &&
+      fseeko(file, MAX(TEXT_CACHE_SAMPLE_SIZE, info.st_size - TEXT_CACHE_SAMPLE_SIZE),
+        SEEK_SET) == 0) {
+    text_cache_update_checksum(checksum, file, buffer);
+  }
+  g_free(buffer);
+  fclose(file);
+
+  char* name     = g_strconcat(g_checksum_get_string(checksum), ".text", NULL);
+  char* filename = g_build_filename(g_get_user_cache_dir(), "zathura-pdf-poppler",
+      name, NULL);
+  g_free(name);
+  g_checksum_free(checksum);
+
+  return filename;
+}
+
+bool
+pdf_text_cache_load(pdf_text_index_t* index, const char* filename)
+{
+  if (index == NULL || filename == NULL) {
+    return false;
+  }
+
+  char* contents = NULL;
+  gsize size     = 0;
+  if (g_file_get_contents(filename, &contents, &size, NULL) == FALSE) {
+    return false;
+  }
+
+  text_cache_reader_t reader = { .data = contents, .size = size, .offset = 0 };
+  const unsigned int n_pages = pdf_text_index_get_n_pages(index);
+  pdf_text_page_t** pages    = g_malloc0(sizeof(pdf_text_page_t*) * MAX(n_pages, 1));
+  bool valid                 = false;
+
+  const char* magic = text_cache_read(&reader, TEXT_CACHE_MAGIC_SIZE);
+  guint32 n_cached  = 0;
+  if (magic == NULL || memcmp(magic, TEXT_CACHE_MAGIC, TEXT_CACHE_MAGIC_SIZE) != 0 ||
+      text_cache_read_uint(&reader, &n_cached) == false || n_cached != n_pages) {
+    goto error_free;
+  }
+
+  for (unsigned int i = 0; i < n_pages; i++) {
+    guint32 text_size = 0;
+    guint32 n_boxes   = 0;
+    if (text_cache_read_uint(&reader, &text_size) == false ||
+        text_cache_read_uint(&reader, &n_boxes) == false) {
+      goto error_free;
+    }
+
+    const char* text = text_cache_read(&reader, text_size);
+    if (text == NULL || g_utf8_validate(text, text_size, NULL) == FALSE ||
+        n_boxes > (reader.size - reader.offset) / (4 * sizeof(float))) {
+      goto error_free;
+    }
+
+    float* boxes = NULL;
+    if (n_boxes > 0) {
+      boxes = g_malloc(sizeof(float) * 4 * n_boxes);
+      memcpy(boxes, text_cache_read(&reader, sizeof(float) * 4 * n_boxes),
+          sizeof(float) * 4 * n_boxes);
+    }
+
+    pages[i] = pdf_text_page_new_from_data(g_strndup(text, text_size), boxes, n_boxes);
+  }
+
+  /* only a file that could be read completely is used */
+  for (unsigned int i = 0; i < n_pages; i++) {
+    pdf_text_index_add_page(index, i, pages[i]);
+    pages[i] = NULL;
+  }
+  valid = true;
+
+  /* mark the file as recently used for pruning */
+  g_utime(filename, NULL);
+
+error_free:
+
+  if (valid == false) {
+    girara_debug("Discarding invalid text cache %s", filename);
+    for (unsigned int i = 0; i < n_pages; i++) {
+      pdf_text_page_free(pages[i]);
+    }
+  }
+
+  g_free(pages);
+  g_free(contents);
+
+  return valid;
+}
+
+bool
+pdf_text_cache_save(pdf_text_index_t* index, const char* filename)
+{
+  if (index == NULL || filename == NULL || pdf_text_index_is_complete(index) == false) {
+    return false;
+  }
+
+  if (g_file_test(filename, G_FILE_TEST_EXISTS) == TRUE) {
+    return true;
+  }
+
+  const unsigned int n_pages = pdf_text_index_get_n_pages(index);
+  GByteArray* array          = g_byte_array_new();
+
+  g_byte_array_append(array, (const guint8*) TEXT_CACHE_MAGIC, TEXT_CACHE_MAGIC_SIZE);
+  text_cache_write_uint(array, n_pages);
+
+  for (unsigned int i = 0; i < n_pages; i++) {
+    const pdf_text_page_t* text_page = pdf_text_index_peek_page(index, i);
+    const size_t text_size           = strlen(text_page->text);
+    const size_t n_boxes             = text_page->boxes != NULL ? text_page->length : 0;
+
+    text_cache_write_uint(array, text_size);
+    text_cache_write_uint(array, n_boxes);
+    g_byte_array_append(array, (const guint8*) text_page->text, text_size);
+    if (n_boxes > 0) {
+      g_byte_array_append(array, (const guint8*) text_page->boxes,
+          sizeof(float) * 4 * n_boxes);
+    }
+  }
+
+  char* directory = g_path_get_dirname(filename);
+  bool saved      = false;
+
+  GError* error = NULL;
+  if (array->len > TEXT_CACHE_MAX_SIZE) {
+    girara_debug("Text of %s is too large for the text cache", filename);
+  } else if (g_mkdir_with_parents(directory, 0700) != 0) {
+    girara_warning("Could not create text cache directory %s", directory);
+  } else if (g_file_set_contents(filename, (const gchar*) array->data, array->len,
+        &error) == FALSE) {
+    girara_warning("Could not write text cache %s: %s", filename, error->message);
+    g_error_free(error);
+  } else {
+    saved = true;
+    text_cache_prune(directory);
+  }
+
+  g_free(directory);
+  g_byte_array_free(array, TRUE);
+
+  return saved;
+}
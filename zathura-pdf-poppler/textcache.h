@@ -0,0 +1,39 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include "text.h"
+
+/**
+ * Returns the file of the on-disk text cache for a document. The name is
+ * derived from the size, the modification time and a hash of the beginning
+ * and the end of the document, so changed files get a different name.
+ *
+ * @param path Path of the document
+ * @return Path of the cache file (needs to be freed with g_free) or NULL if
+ *   an error occurred
+ */
+GIRARA_HIDDEN char* pdf_text_cache_get_filename(const char* path);
+
+/**
+ * Loads the text of all pages from a cache file into the index
+ *
+ * @param index The index
+ * @param filename Path of the cache file
+ * @return true if the cache file was loaded
+ */
+GIRARA_HIDDEN bool pdf_text_cache_load(pdf_text_index_t* index, const char* filename);
+
+/**
+ * Writes a complete index to a cache file unless the file exists already.
+ * Afterwards the least recently used files of the cache directory are
+ * deleted until all files fit into the size limit of the cache.
+ *
+ * @param index The index
+ * @param filename Path of the cache file
+ * @return true if the cache file exists afterwards
+ */
+GIRARA_HIDDEN bool pdf_text_cache_save(pdf_text_index_t* index, const char* filename);
+
+#endif // TEXTCACHE_H
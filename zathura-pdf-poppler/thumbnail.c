@@ -0,0 +1,261 @@
+/* See LICENSE file for license and copyright information */
+
+#include <math.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+#include <girara/utils.h>
+
+#include "pngtext.h"
+#include "thumbnail.h"
+
+typedef struct thumbnail_job_s {
+  pdf_thumbnails_t* thumbnails; /**< The thumbnails */
+  unsigned int index; /**< Page index */
+} thumbnail_job_t;
+
+struct pdf_thumbnails_s {
+  unsigned int size; /**< Maximal width and height */
+  char* uri; /**< URI of the document */
+  char* directory; /**< Cache directory for the size */
+  gint64 mtime; /**< Modification time of the document */
+  unsigned int n_pages; /**< Number of pages */
+  thumbnail_job_t* jobs; /**< Jobs by page index */
+};
+
+/* Returns the URI of a page: the URI of the document with the page number as
+ * fragment, like in the PDF open parameters */
+static char*
+thumbnail_get_uri(pdf_thumbnails_t* thumbnails, unsigned int index)
+{
+  return g_strdup_printf("%s#page=%u", thumbnails->uri, index + 1);
+}
+
+static char*
+thumbnail_get_filename(pdf_thumbnails_t* thumbnails, const char* uri)
+{
+  char* hash     = g_compute_checksum_for_string(G_CHECKSUM_MD5, uri, -1);
+  char* name     = g_strdup_printf("%s.png", hash);
+  char* filename = g_build_filename(thumbnails->directory, name, NULL);
+  g_free(name);
+  g_free(hash);
+
+  return filename;
+}
+
+/* Checks if the cache holds an up-to-date thumbnail of the page */
+static bool
+thumbnail_is_cached(pdf_thumbnails_t* thumbnails, const char* filename, const char* uri)
+{
+  gchar* data = NULL;
+  gsize size  = 0;
+  if (g_file_get_contents(filename, &data, &size, NULL) == FALSE) {
+    return false;
+  }
+
+  /* the URI and the modification time identify the thumbnail, as described
+   * by the thumbnail specification */
+  char* mtime              = g_strdup_printf("%" G_GINT64_FORMAT, thumbnails->mtime);
+  const char* const text[] = { "Thumb::URI", uri, "Thumb::MTime", mtime, NULL };
+  const bool cached        = pdf_png_has_text((const guint8*) data, size, text);
+
+  g_free(mtime);
+  g_free(data);
+
+  return cached;
+}
+
+/* Writes a thumbnail to a temporary file that is renamed to the target, so
+ * that readers never see incomplete files */
+static void
+thumbnail_save(pdf_thumbnails_t* thumbnails, const char* filename, const char* uri,
+    cairo_surface_t* surface)
+{
+  char* mtime              = g_strdup_printf("%" G_GINT64_FORMAT, thumbnails->mtime);
+  const char* const text[] = {
+    "Thumb::URI", uri, "Thumb::MTime", mtime, "Software", "zathura-pdf-poppler", NULL
+  };
+  GByteArray* png = pdf_png_encode(surface, text);
+  g_free(mtime);
+
+  if (png == NULL) {
+    return;
+  }
+
+  char* tmp = g_strdup_printf("%s.XXXXXX", filename);
+  int fd    = g_mkstemp(tmp);
+  if (fd != -1) {
+    gsize written = 0;
+    while (written < png->len) {
+      const ssize_t ret = write(fd, png->data + written, png->len - written);
+      if (ret <= 0) {
+        break;
+      }
+      written += ret;
+    }
+
+    if (close(fd) != 0 || written != png->len || g_rename(tmp, filename) != 0) {
+      girara_debug("Could not write thumbnail '%s'", filename);
+      g_unlink(tmp);
+    }
+  }
+
+  g_free(tmp);
+  g_byte_array_free(png, TRUE);
+}
+
+static void
+thumbnail_job(PopplerDocument* poppler_document, void* data)
+{
+  thumbnail_job_t* job         = data;
+  pdf_thumbnails_t* thumbnails = job->thumbnails;
+
+  /* discarded jobs have nothing to do */
+  if (poppler_document == NULL) {
+    return;
+  }
+
+  char* uri      = thumbnail_get_uri(thumbnails, job->index);
+  char* filename = thumbnail_get_filename(thumbnails, uri);
+
+  if (thumbnail_is_cached(thumbnails, filename, uri) == false) {
+    PopplerPage* poppler_page = poppler_document_get_page(poppler_document, job->index);
+    if (poppler_page != NULL) {
+      cairo_surface_t* surface = pdf_page_render_thumbnail(poppler_page, thumbnails->size);
+      g_object_unref(poppler_page);
+
+      /* the thumbnails are only kept in the cache */
+      if (surface != NULL) {
+        thumbnail_save(thumbnails, filename, uri, surface);
+        cairo_surface_destroy(surface);
+      }
+    }
+  }
+
+  g_free(filename);
+  g_free(uri);
+}
+
+/* Returns the smallest size of the thumbnail specification that holds
+ * thumbnails of the given size; sizes above the largest one are reduced */
+static unsigned int
+thumbnail_get_cache_size(unsigned int size, const char** name)
+{
+  if (size <= 128) {
+    *name = "normal";
+    return 128;
+  } else if (size <= 256) {
+    *name = "large";
+    return 256;
+  } else if (size <= 512) {
+    *name = "x-large";
+    return 512;
+  }
+
+  if (size > 1024) {
+    girara_warning("Thumbnail size %u is larger than 1024, using 1024", size);
+  }
+
+  *name = "xx-large";
+  return 1024;
+}
+
+pdf_thumbnails_t*
+pdf_thumbnails_new(pdf_document_t* pdf_document, pdf_pool_t* pool, unsigned int size)
+{
+  if (pdf_document == NULL || pool == NULL || size == 0) {
+    return NULL;
+  }
+
+  /* thumbnails of encrypted documents are not written to the shared cache */
+  struct stat info;
+  if (pdf_document->password != NULL || stat(pdf_document->path, &info) != 0) {
+    return NULL;
+  }
+
+  const char* name             = NULL;
+  pdf_thumbnails_t* thumbnails = g_malloc0(sizeof(pdf_thumbnails_t));
+  thumbnails->size             = thumbnail_get_cache_size(size, &name);
+  thumbnails->n_pages          = pdf_document->number_of_pages;
+  thumbnails->jobs             = g_malloc0(sizeof(thumbnail_job_t) * MAX(thumbnails->n_pages, 1));
+
+  char* path = NULL;
+  if (g_path_is_absolute(pdf_document->path) == TRUE) {
+    path = g_strdup(pdf_document->path);
+  } else {
+    char* cwd = g_get_current_dir();
+    path      = g_build_filename(cwd, pdf_document->path, NULL);
+    g_free(cwd);
+  }
+
+  thumbnails->uri       = g_filename_to_uri(path, NULL, NULL);
+  thumbnails->mtime     = info.st_mtime;
+  thumbnails->directory = g_build_filename(g_get_user_cache_dir(), "thumbnails", name, NULL);
+  g_free(path);
+
+  if (thumbnails->uri == NULL || g_mkdir_with_parents(thumbnails->directory, 0700) != 0) {
+    pdf_thumbnails_free(thumbnails);
+    return NULL;
+  }
+
+  for (unsigned int i = 0; i < thumbnails->n_pages; i++) {
+    thumbnails->jobs[i].thumbnails = thumbnails;
+    thumbnails->jobs[i].index      = i;
+    pdf_pool_push(pool, NULL, thumbnail_job, &thumbnails->jobs[i], false);
+  }
+
+  return thumbnails;
+}
+
+void
+pdf_thumbnails_free(pdf_thumbnails_t* thumbnails)
+{
+  if (thumbnails == NULL) {
+    return;
+  }
+
+  g_free(thumbnails->jobs);
+  g_free(thumbnails->uri);
+  g_free(thumbnails->directory);
+  g_free(thumbnails);
+}
+
+cairo_surface_t*
+pdf_page_render_thumbnail(PopplerPage* poppler_page, unsigned int size)
+{
+  if (poppler_page == NULL || size == 0) {
+    return NULL;
+  }
+
+  double width  = 0;
+  double height = 0;
+  poppler_page_get_size(poppler_page, &width, &height);
+  if (width <= 0 || height <= 0) {
+    return NULL;
+  }
+
+  const double scale       = size / MAX(width, height);
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+      CLAMP((int) round(width * scale), 1, (int) size),
+      CLAMP((int) round(height * scale), 1, (int) size));
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+
+  cairo_t* cairo = cairo_create(surface);
+  cairo_set_source_rgb(cairo, 1, 1, 1);
+  cairo_paint(cairo);
+  cairo_scale(cairo, scale, scale);
+  poppler_page_render(poppler_page, cairo);
+  const cairo_status_t status = cairo_status(cairo);
+  cairo_destroy(cairo);
+
+  if (status != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+
+  return surface;
+}
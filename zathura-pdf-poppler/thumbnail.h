@@ -0,0 +1,46 @@
+/* See LICENSE file for license and copyright information */
+
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+#include "plugin.h"
+#include "pool.h"
+
+typedef struct pdf_thumbnails_s pdf_thumbnails_t;
+
+/**
+ * Fills the thumbnail cache of the freedesktop.org thumbnail specification
+ * ($XDG_CACHE_HOME/thumbnails) with all pages of a document in the
+ * background. Every page that is not cached yet is rendered at low
+ * resolution by the workers of the pool and written to the cache; the
+ * thumbnails are not kept in memory.
+ *
+ * @param pdf_document Internal document representation
+ * @param pool Background pool of the document (needs to be freed before the
+ *   thumbnails)
+ * @param size Maximal width and height of a thumbnail in pixels
+ * @return The thumbnails or NULL if the document can not be cached or an
+ *   error occurred
+ */
+GIRARA_HIDDEN pdf_thumbnails_t* pdf_thumbnails_new(pdf_document_t* pdf_document,
+    pdf_pool_t* pool, unsigned int size);
+
+/**
+ * Frees the thumbnails
+ *
+ * @param thumbnails The thumbnails
+ */
+GIRARA_HIDDEN void pdf_thumbnails_free(pdf_thumbnails_t* thumbnails);
+
+/**
+ * Renders a page at low resolution so that it fits into a square of the
+ * given size
+ *
+ * @param poppler_page The poppler page
+ * @param size Maximal width and height in pixels
+ * @return The image surface or NULL if an error occurred
+ */
+GIRARA_HIDDEN cairo_surface_t* pdf_page_render_thumbnail(PopplerPage* poppler_page,
+    unsigned int size);
+
+#endif // THUMBNAIL_H
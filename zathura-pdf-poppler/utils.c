@@ -1,9 +1,11 @@
 /* See LICENSE file for license and copyright information */
 
+#include <girara/utils.h>
+
 #include "utils.h"
 
 zathura_link_t*
-poppler_link_to_zathura_link(PopplerDocument* poppler_document, PopplerAction*
+poppler_link_to_zathura_link(pdf_document_t* pdf_document, PopplerAction*
     poppler_action, zathura_rectangle_t position)
 {
   zathura_link_type_t type     = ZATHURA_LINK_INVALID;
@@ -15,7 +17,7 @@ poppler_link_to_zathura_link(PopplerDocument* poppler_document, PopplerAction*
       type = ZATHURA_LINK_NONE;
       break;
     case POPPLER_ACTION_GOTO_DEST: {
-      PopplerDest* poppler_destination = poppler_action->goto_dest.dest;
+      const PopplerDest* poppler_destination = poppler_action->goto_dest.dest;
       if (poppler_destination == NULL) {
         return NULL;
       }
@@ -23,15 +25,14 @@ poppler_link_to_zathura_link(PopplerDocument* poppler_document, PopplerAction*
       type = ZATHURA_LINK_GOTO_DEST;
 
       if (poppler_action->goto_dest.dest->type == POPPLER_DEST_NAMED) {
-        poppler_destination = poppler_document_find_dest(poppler_document, poppler_destination->named_dest);
+        poppler_destination = pdf_document_find_dest(pdf_document, poppler_destination->named_dest);
         if (poppler_destination == NULL) {
           return NULL;
         }
       }
 
-      PopplerPage* poppler_page = poppler_document_get_page(poppler_document, poppler_destination->page_num - 1);
-      double height = 0;
-      poppler_page_get_size(poppler_page, NULL, &height);
+      const double height = pdf_document_get_page_height(pdf_document,
+          poppler_destination->page_num - 1);
 
       switch (poppler_destination->type) {
         case POPPLER_DEST_XYZ:
@@ -126,3 +127,45 @@ poppler_link_to_zathura_link(PopplerDocument* poppler_document, PopplerAction*
 
   return zathura_link_new(type, position, target);
 }
+
+bool
+pdf_env_get_bool(const char* name, bool default_value)
+{
+  const char* value = g_getenv(name);
+  if (value == NULL || *value == '\0') {
+    return default_value;
+  }
+
+  static const char* true_values[]  = { "1", "true", "yes", "on" };
+  static const char* false_values[] = { "0", "false", "no", "off" };
+
+  for (unsigned int i = 0; i < G_N_ELEMENTS(true_values); i++) {
+    if (g_ascii_strcasecmp(value, true_values[i]) == 0) {
+      return true;
+    }
+    if (g_ascii_strcasecmp(value, false_values[i]) == 0) {
+      return false;
+    }
+  }
+
+  girara_warning("Invalid value '%s' for %s", value, name);
+  return default_value;
+}
+
+unsigned int
+pdf_env_get_uint(const char* name, unsigned int default_value)
+{
+  const char* value = g_getenv(name);
+  if (value == NULL || *value == '\0') {
+    return default_value;
+  }
+
+  char* end = NULL;
+  const guint64 result = g_ascii_strtoull(value, &end, 10);
+  if (end == value || *end != '\0' || result > G_MAXUINT) {
+    girara_warning("Invalid value '%s' for %s", value, name);
+    return default_value;
+  }
+
+  return result;
+}
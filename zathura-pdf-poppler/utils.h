@@ -8,13 +8,33 @@
 /**
  * Convert a poppler link object to a zathura link object
  *
- * @param poppler_document The poppler document
+ * @param pdf_document The document
  * @param poppler_action The poppler action
  * @param position The position of the link
  *
  * @return Zathura link object 
  */
-GIRARA_HIDDEN zathura_link_t* poppler_link_to_zathura_link(PopplerDocument* poppler_document,
+GIRARA_HIDDEN zathura_link_t* poppler_link_to_zathura_link(pdf_document_t* pdf_document,
     PopplerAction* poppler_action, zathura_rectangle_t position);
 
+/**
+ * Reads a boolean setting from the environment
+ *
+ * Accepted values are 1/0, true/false, yes/no and on/off.
+ *
+ * @param name Name of the environment variable
+ * @param default_value Value to use if the variable is not set or invalid
+ * @return The value of the setting
+ */
+GIRARA_HIDDEN bool pdf_env_get_bool(const char* name, bool default_value);
+
+/**
+ * Reads an unsigned integer setting from the environment
+ *
+ * @param name Name of the environment variable
+ * @param default_value Value to use if the variable is not set or invalid
+ * @return The value of the setting
+ */
+GIRARA_HIDDEN unsigned int pdf_env_get_uint(const char* name, unsigned int default_value);
+
 #endif // UTILS_H